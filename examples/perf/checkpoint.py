@@ -0,0 +1,52 @@
+from woo.core import *; from woo.dem import *
+import woo, woo.pack
+import os, os.path, sys, time
+from minieigen import *
+import math
+# compare save/load time and file size of ColumnarCheckpoint with boost::serialization (.bin.gz)
+outName='checkpoint-timings.txt'
+r=.1
+if len(sys.argv)==1:
+	tag,N,steps='',20,500
+else:
+	if len(sys.argv)!=4: raise RuntimeError("Exactly 3 argument must be given: tag N steps")
+	tag,N,steps=sys.argv[1],int(sys.argv[2]),int(sys.argv[3])
+
+S=woo.master.scene=Scene(fields=[DemField(gravity=Quaternion((.3,.7,0),math.radians(15))*Vector3(0,0,-9.81))])
+mat=FrictMat(young=1e7,ktDivKn=.2,density=2500)
+S.dem.par.append(Wall.make(-r,axis=2,sense=1,mat=mat))
+S.dem.par.append(woo.pack.regularOrtho(woo.pack.inAlignedBox((0,0,0),(2*N+1)*r*Vector3.Ones),radius=r,gap=0,mat=mat))
+S.dem.collectNodes()
+S.engines=DemField.minimalEngines(damping=.5)
+# have some contacts
+S.run(steps,True)
+print 'Number of spheres',len(S.dem.par)-1,', contacts',len(S.dem.con)
+
+base=woo.master.tmpFilename()
+results=[]
+for fmt,ext in [('boost','.bin.gz'),('boost','.bin'),('columnar','.wooc'),('columnar','.wooc.gz'),('columnar','.wooc.bgz')]:
+	out=base+ext
+	t0=time.time()
+	if fmt=='boost': S.save(out)
+	else:
+		st=ColumnarCheckpoint.save(S,out)
+		if ext=='.wooc': print 'Columnar: %(parColumnar)d particles, %(conColumnar)d contacts; boost::serialization: %(parType)d+%(parShared)d particles, %(conType)d+%(conShared)d contacts (other type + referenced)'%st
+	tSave=time.time()-t0
+	size=os.path.getsize(out)
+	t0=time.time()
+	S2=Object.load(out)
+	tLoad=time.time()-t0
+	assert len(S2.dem.par)==len(S.dem.par) and len(S2.dem.con)==len(S.dem.con)
+	os.remove(out)
+	results.append((ext,tSave,tLoad,size))
+	print '%-10s %8.3fs save %8.3fs load %12d bytes'%(ext,tSave,tLoad,size)
+
+ref=results[0]
+for ext,tSave,tLoad,size in results[1:]:
+	print '%-10s vs %s: save %5.2fx faster, load %5.2fx faster, %5.2fx smaller'%(ext,ref[0],ref[1]/tSave,ref[2]/tLoad,ref[3]*1./size)
+
+if tag:
+	newOut=not os.path.exists(outName)
+	out=open(outName,'a')
+	if newOut: out.write("#tag\tcores\tnPar\tnCon\tformat\ttSave\ttLoad\tsize\n")
+	for ext,tSave,tLoad,size in results: out.write('%s\t%d\t%d\t%d\t%s\t%f\t%f\t%d\n'%(tag,woo.master.numThreads,len(S.dem.par)-1,len(S.dem.con),ext,tSave,tLoad,size))
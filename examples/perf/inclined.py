@@ -5,6 +5,8 @@ from minieigen import *
 import math
 import numpy as np
 periodic=False
+# accumulate contact forces in per-thread buffers (ContactLoop.threadForces)
+threadForces=bool(int(os.environ.get('WOO_THREADFORCES','0')))
 outName='timings.txt'
 r=.1
 if len(sys.argv)==1:
@@ -19,6 +21,7 @@ S.dem.par.append(Wall.make(-r,axis=2,sense=1,mat=mat))
 S.dem.par.append(woo.pack.regularOrtho(woo.pack.inAlignedBox((0,0,0),(2*N+1)*r*Vector3.Ones),radius=r,gap=0,mat=mat))
 S.dem.collectNodes()
 S.engines=DemField.minimalEngines(damping=.5)
+S.lab.contactLoop.threadForces=threadForces
 if periodic:
 	S.periodic=True
 	S.cell.setBox(4*N*r*Vector3.Ones)
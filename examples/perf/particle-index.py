@@ -0,0 +1,8 @@
+from woo.core import *; from woo.dem import *
+import woo
+import sys
+# per-particle contact index (Particle.allContacts) vs. std::map, times per operation in ns
+coordNums=[int(a) for a in sys.argv[1:]] if len(sys.argv)>1 else [4,6,8,12,16,20]
+print 'coord  insert(idx/map)  find(idx/map)  findMiss(idx/map)  erase(idx/map)  [ns/op]'
+for d in ContactContainer.benchParticleIndex(coordNums=coordNums,nPar=10000,nRep=10):
+	print '%4d  %6.1f/%6.1f  %6.1f/%6.1f  %6.1f/%6.1f  %6.1f/%6.1f'%(d['coordNum'],d['insert'],d['mapInsert'],d['find'],d['mapFind'],d['findMiss'],d['mapFindMiss'],d['erase'],d['mapErase'])
@@ -0,0 +1,38 @@
+# compare HierGridCollider and InsertionSortCollider on graded PSD with radius ratio 1:50
+# non-periodic variant of examples/psd-graded.py (HierGridCollider does not support periodic boundaries)
+from woo.core import *; from woo.dem import *
+import woo, woo.pack, woo.timing
+import os.path, sys
+from minieigen import *
+# collider to use: 'sort' (InsertionSortCollider) or 'hier' (HierGridCollider)
+collider=os.environ.get('WOO_COLLIDER','hier')
+outName='timings.txt'
+if len(sys.argv)==1:
+	tag,N,steps='',10000,1000
+else:
+	if len(sys.argv)!=4: raise RuntimeError("Exactly 3 argument must be given: tag N steps")
+	tag,N,steps=sys.argv[1],int(sys.argv[2]),int(sys.argv[3])
+
+S=woo.master.scene=Scene(fields=[DemField(gravity=(0,-.2,-1))])
+mat=FrictMat(density=1000,young=1e6,tanPhi=.9)
+psd=[(.002,0),(.01,.3),(.03,.7),(.1,1)]
+box=AlignedBox3((0,0,0),(1,1,2))
+S.dem.par.add([Wall.make(box.min[ax],axis=ax,sense=1,mat=mat) for ax in (0,1,2)]+[Wall.make(box.max[ax],axis=ax,sense=-1,mat=mat) for ax in (0,1)],nodes=False)
+S.engines=[BoxInlet(box=box,generator=PsdSphereGenerator(psdPts=psd),maxMass=-1,maxNum=N,massRate=0,maxAttempts=5000,materials=[mat],collideExisting=False)]
+S.one()
+S.engines=DemField.minimalEngines(damping=.4,grid=('hier' if collider=='hier' else False))
+print 'Number of spheres',len(S.dem.par)-5,'collider',S.lab.collider.__class__.__name__
+
+woo.master.timingEnabled=True
+S.one()
+t1=1e-9*sum([e.execTime for e in S.engines])
+woo.timing.reset()
+if tag:
+	S.run(steps,True)
+	t=1e-9*sum([e.execTime for e in S.engines])/(S.step-1)
+	colliderRel=S.lab.collider.execTime*1./sum([e.execTime for e in S.engines])
+
+	newOut=not os.path.exists(outName)
+	out=open(outName,'a')
+	if newOut: out.write("#tag\tcores\tnPar\tnSteps\tt1\tt\tcolliderRel\n")
+	out.write('%s\t%d\t%d\t%d\t%f\t%.8f\t%f\n'%(tag,woo.master.numThreads,len(S.dem.par)-5,S.step-1,t1,t,colliderRel))
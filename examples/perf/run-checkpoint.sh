@@ -0,0 +1,5 @@
+WOO=woo-mt
+# ColumnarCheckpoint vs boost::serialization: save/load time and file size (checkpoint-timings.txt)
+for j in 1 4; do
+	for N in 10 20 30 50; do $WOO -xn -j$j checkpoint.py checkpoint $N 500; done
+done
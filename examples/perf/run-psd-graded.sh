@@ -0,0 +1,8 @@
+WOO=woo-mt
+# compare InsertionSortCollider and HierGridCollider (tags sort and hier in timings.txt)
+for j in 1 4 16; do
+	for coll in sort hier; do
+		for i in `seq 3`; do WOO_COLLIDER=$coll $WOO -xn -j$j psd-graded.py $coll 20000 1000; done
+		WOO_COLLIDER=$coll $WOO -xn -j$j psd-graded.py $coll 100000 1000
+	done
+done
@@ -0,0 +1,8 @@
+WOO=woo-mt
+# compare ContactLoop.threadForces with locking DemData (tags threadForces0 and threadForces1 in timings.txt)
+for j in 1 4 16 64; do
+	for tf in 0 1; do
+		for i in `seq 3`; do WOO_THREADFORCES=$tf $WOO -xn -j$j inclined.py threadForces$tf 30 1000; done
+		WOO_THREADFORCES=$tf $WOO -xn -j$j inclined.py threadForces$tf 50 1000
+	done
+done
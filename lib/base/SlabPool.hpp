@@ -0,0 +1,107 @@
+// Slab allocator for small, frequently created and destroyed objects (contacts and their geometry/physics).
+#pragma once
+
+#include<woo/lib/base/Types.hpp>
+#include<boost/thread/mutex.hpp>
+#include<boost/make_shared.hpp>
+#include<cstdlib>
+#include<new>
+#include<limits>
+
+namespace woo{
+	/*
+	Pool of fixed-size blocks (one pool per block size), carved from 64k slabs.
+
+	Each thread keeps its own free list, so that allocation and deallocation are O(1) and
+	don't touch any lock or atomic in the common case; blocks are exchanged with the global
+	free list (under a mutex) in batches, when a thread runs out of blocks or accumulates too many.
+
+	Memory use:
+	* slabs are never returned to the system: memory used by the pool stays at its peak (e.g. the largest
+	  number of contacts during the simulation), and is only reused by later allocations of the same size;
+	* a block goes to the free list of the thread which frees it, not of the one which allocated it; blocks
+	  thus migrate between threads (and lose adjacency), and each thread may hold up to 4*batch free blocks
+	  per block size before handing them over to the global list;
+	* free blocks held by a thread when it exits are not reclaimed; the pool is meant for long-lived
+	  (OpenMP worker and main) threads.
+
+	Objects allocated from the same thread in sequence occupy adjacent memory, which keeps
+	e.g. contacts created by the collider together in memory.
+	*/
+	template<size_t Size>
+	class SlabPool{
+		struct FreeBlock{ FreeBlock* next; };
+		// POD, so that there is no destructor to run at thread exit
+		struct Local{ FreeBlock* head; size_t count; };
+		struct Global{ boost::mutex mutex; FreeBlock* head; size_t count; Global(): head(nullptr), count(0){} };
+		static Local& local(){ static thread_local Local l={nullptr,0}; return l; }
+		// allocated on the heap and never deleted, so that it outlives any static object freeing its blocks at exit
+		static Global& global(){ static Global* g=new Global; return *g; }
+		static void refill(Local& l){
+			Global& g(global());
+			boost::mutex::scoped_lock lock(g.mutex);
+			if(g.count>=batch){
+				for(size_t i=0; i<batch; i++){ FreeBlock* b=g.head; g.head=b->next; b->next=l.head; l.head=b; }
+				g.count-=batch; l.count+=batch;
+				return;
+			}
+			void* slab;
+			if(posix_memalign(&slab,64,blocksPerSlab*blockSize)!=0) throw std::bad_alloc();
+			// push in reverse, so that blocks are handed out in increasing address order
+			for(size_t i=blocksPerSlab; i>0; i--){ FreeBlock* b=(FreeBlock*)((char*)slab+(i-1)*blockSize); b->next=l.head; l.head=b; }
+			l.count+=blocksPerSlab;
+		}
+		static void giveBack(Local& l){
+			Global& g(global());
+			boost::mutex::scoped_lock lock(g.mutex);
+			for(size_t i=0; i<batch; i++){ FreeBlock* b=l.head; l.head=b->next; b->next=g.head; g.head=b; }
+			l.count-=batch; g.count+=batch;
+		}
+	public:
+		// blocks are multiples of 16 bytes, which satisfies alignment of Eigen's fixed-size vectorizable types
+		static const size_t blockSize=((Size<sizeof(FreeBlock)?sizeof(FreeBlock):Size)+15)&~size_t(15);
+		static const size_t blocksPerSlab=(blockSize<(1<<16)/8?(1<<16)/blockSize:8);
+		static const size_t batch=(blocksPerSlab<256?blocksPerSlab:256);
+		static void* allocate(){
+			Local& l(local());
+			if(!l.head) refill(l);
+			FreeBlock* b=l.head; l.head=b->next; l.count--;
+			return (void*)b;
+		}
+		static void deallocate(void* p){
+			Local& l(local());
+			FreeBlock* b=(FreeBlock*)p; b->next=l.head; l.head=b; l.count++;
+			if(l.count>4*batch) giveBack(l);
+		}
+	};
+
+	// standard allocator drawing single objects from SlabPool; arrays go to the global operator new
+	template<typename T>
+	struct SlabAllocator{
+		typedef T value_type;
+		typedef T* pointer; typedef const T* const_pointer;
+		typedef T& reference; typedef const T& const_reference;
+		typedef size_t size_type; typedef ptrdiff_t difference_type;
+		template<typename U> struct rebind{ typedef SlabAllocator<U> other; };
+		SlabAllocator(){}
+		template<typename U> SlabAllocator(const SlabAllocator<U>&){}
+		T* allocate(size_t n, const void* hint=0){
+			static_assert(alignof(T)<=16,"SlabAllocator: types with alignment over 16 bytes are not supported.");
+			if(n==1) return (T*)SlabPool<sizeof(T)>::allocate();
+			return (T*)::operator new(n*sizeof(T));
+		}
+		void deallocate(T* p, size_t n){
+			if(n==1) SlabPool<sizeof(T)>::deallocate((void*)p);
+			else ::operator delete((void*)p);
+		}
+		template<typename U, typename... Args> void construct(U* p, Args&&... args){ ::new((void*)p) U(std::forward<Args>(args)...); }
+		template<typename U> void destroy(U* p){ p->~U(); }
+		size_t max_size() const { return std::numeric_limits<size_t>::max()/sizeof(T); }
+		template<typename U> bool operator==(const SlabAllocator<U>&) const { return true; }
+		template<typename U> bool operator!=(const SlabAllocator<U>&) const { return false; }
+	};
+
+	// like make_shared, but the object (together with the reference count) lives in SlabPool
+	template<typename T, typename... Args>
+	shared_ptr<T> slab_make_shared(Args&&... args){ return boost::allocate_shared<T>(SlabAllocator<T>(),std::forward<Args>(args)...); }
+}
@@ -52,7 +52,7 @@ class OpenMPArrayAccumulator{
 		OpenMPArrayAccumulator()        : CLS(_WOO_L1_CACHE_LINESIZE), nThreads(omp_get_max_threads()), perCL(CLS/sizeof(T)), chunks(nThreads,NULL), sz(0), nCL(0) { }
 		OpenMPArrayAccumulator(const OpenMPArrayAccumulator& a): OpenMPArrayAccumulator() {
 			this->resize(a.sz);
-			for(size_t th=0; th<nThreads; th++) memcpy((void*)(chunks[th]),(void*)(a.chunks[th]),nCL_for_N(sz));
+			for(size_t th=0; th<nThreads; th++) memcpy((void*)(chunks[th]),(void*)(a.chunks[th]),nCL_for_N(sz)*CLS);
 		}
 		OpenMPArrayAccumulator(size_t n): CLS(_WOO_L1_CACHE_LINESIZE), nThreads(omp_get_max_threads()), perCL(CLS/sizeof(T)), chunks(nThreads,NULL), sz(0), nCL(0) { resize(n); }
 		// change number of elements
@@ -83,9 +83,9 @@ class OpenMPArrayAccumulator{
 							_aligned_free(oldChunk); // free is illegal with _aligned_malloc
 						#endif
 					}
-					nCL=nCL_new;
 				}
-				
+				// only after all chunks were copied, as nCL is the size of old chunks above
+				nCL=nCL_new;
 			}
 			// if nCL_new<nCL, do not deallocate memory
 			// if nCL_new==nCL, only update sz
@@ -0,0 +1,143 @@
+#include<woo/lib/object/Bgzf.hpp>
+#include<zlib.h>
+#ifdef WOO_OPENMP
+	#include<omp.h>
+#endif
+
+namespace woo{ namespace bgzf{
+
+const char eofBlock[28]={'\x1f','\x8b','\x08','\x04',0,0,0,0,0,'\xff','\x06',0,'B','C','\x02',0,'\x1b',0,'\x03',0,0,0,0,0,0,0,0,0};
+
+size_t batchBlocks(){
+	#ifdef WOO_OPENMP
+		return 64*omp_get_max_threads();
+	#else
+		return 64;
+	#endif
+}
+
+static void putLE16(unsigned char* p, unsigned v){ p[0]=v&0xff; p[1]=(v>>8)&0xff; }
+static void putLE32(unsigned char* p, uint32_t v){ for(int i=0; i<4; i++) p[i]=(v>>(8*i))&0xff; }
+static uint32_t getLE32(const unsigned char* p){ return p[0]|(p[1]<<8)|(p[2]<<16)|((uint32_t)p[3]<<24); }
+
+// compress one block into out (BLOCK_MAX bytes); returns the block size
+static size_t compressBlock(z_stream& zs, int level, const char* in, size_t n, unsigned char* out){
+	// store without compression if the compressed data don't fit into the block
+	for(int lev: {level,0}){
+		deflateReset(&zs);
+		deflateParams(&zs,lev,Z_DEFAULT_STRATEGY);
+		zs.next_in=(Bytef*)in; zs.avail_in=n;
+		zs.next_out=out+HEADER; zs.avail_out=BLOCK_MAX-HEADER-FOOTER;
+		int err=deflate(&zs,Z_FINISH);
+		if(err!=Z_STREAM_END){
+			if(lev!=0 && (err==Z_OK || err==Z_BUF_ERROR)) continue;
+			throw std::runtime_error("BGZF: deflate failed ("+std::to_string(err)+").");
+		}
+		const size_t cSize=BLOCK_MAX-HEADER-FOOTER-zs.avail_out;
+		const size_t bSize=HEADER+cSize+FOOTER;
+		const unsigned char hdr[12]={0x1f,0x8b,0x08,0x04,0,0,0,0,0,0xff,0x06,0};
+		memcpy(out,hdr,12);
+		out[12]='B'; out[13]='C'; putLE16(out+14,2); putLE16(out+16,bSize-1);
+		putLE32(out+HEADER+cSize,crc32(crc32(0,NULL,0),(const Bytef*)in,n));
+		putLE32(out+HEADER+cSize+4,n);
+		return bSize;
+	}
+	throw std::logic_error("BGZF: unable to compress block?!");
+}
+
+void compress(const char* in, size_t n, std::string& out, int level){
+	const long nBlocks=(n+BLOCK_IN-1)/BLOCK_IN;
+	std::vector<std::vector<unsigned char>> blocks(nBlocks);
+	std::vector<size_t> sizes(nBlocks);
+	std::string err;
+	#ifdef WOO_OPENMP
+		#pragma omp parallel
+	#endif
+	{
+		z_stream zs; memset(&zs,0,sizeof(zs));
+		// raw deflate (negative window bits), gzip header is written by hand
+		bool ok=(deflateInit2(&zs,level,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY)==Z_OK);
+		#ifdef WOO_OPENMP
+			#pragma omp for schedule(dynamic,4)
+		#endif
+		for(long i=0; i<nBlocks; i++){
+			if(!ok) continue;
+			try{
+				blocks[i].resize(BLOCK_MAX);
+				sizes[i]=compressBlock(zs,level,in+i*BLOCK_IN,std::min((size_t)BLOCK_IN,n-i*BLOCK_IN),blocks[i].data());
+			} catch(std::exception& e){
+				#ifdef WOO_OPENMP
+					#pragma omp critical
+				#endif
+				err=e.what();
+			}
+		}
+		if(ok) deflateEnd(&zs);
+		else{
+			#ifdef WOO_OPENMP
+				#pragma omp critical
+			#endif
+			err="BGZF: deflateInit2 failed.";
+		}
+	}
+	if(!err.empty()) throw std::runtime_error(err);
+	size_t total=0;
+	for(const size_t& s: sizes) total+=s;
+	out.reserve(out.size()+total);
+	for(long i=0; i<nBlocks; i++) out.append((const char*)blocks[i].data(),sizes[i]);
+}
+
+size_t blockSize(const unsigned char* hdr){
+	if(hdr[0]!=0x1f || hdr[1]!=0x8b || hdr[2]!=0x08) throw std::runtime_error("BGZF: invalid gzip header.");
+	if(!(hdr[3]&0x04) || hdr[10]!=6 || hdr[11]!=0 || hdr[12]!='B' || hdr[13]!='C' || hdr[14]!=2 || hdr[15]!=0) throw std::runtime_error("BGZF: gzip block without the 'BC' field (not compressed with bgzip or woo?).");
+	size_t sz=(hdr[16]|(hdr[17]<<8))+1;
+	if(sz<HEADER+FOOTER) throw std::runtime_error("BGZF: invalid block size.");
+	return sz;
+}
+
+void decompress(const std::string& blocks, const std::vector<size_t>& offsets, std::string& out){
+	const long nBlocks=offsets.size()-1;
+	const unsigned char* b=(const unsigned char*)blocks.data();
+	std::vector<size_t> outOff(nBlocks+1);
+	outOff[0]=out.size();
+	for(long i=0; i<nBlocks; i++) outOff[i+1]=outOff[i]+getLE32(b+offsets[i+1]-4);
+	out.resize(outOff[nBlocks]);
+	std::string err;
+	#ifdef WOO_OPENMP
+		#pragma omp parallel
+	#endif
+	{
+		z_stream zs; memset(&zs,0,sizeof(zs));
+		bool ok=(inflateInit2(&zs,-15)==Z_OK);
+		#ifdef WOO_OPENMP
+			#pragma omp for schedule(dynamic,4)
+		#endif
+		for(long i=0; i<nBlocks; i++){
+			if(!ok) continue;
+			const size_t sz=outOff[i+1]-outOff[i];
+			inflateReset(&zs);
+			zs.next_in=(Bytef*)(b+offsets[i]+HEADER); zs.avail_in=offsets[i+1]-offsets[i]-HEADER-FOOTER;
+			zs.next_out=(Bytef*)&out[outOff[i]]; zs.avail_out=sz;
+			int ret=inflate(&zs,Z_FINISH);
+			const char* msg=NULL;
+			if(ret!=Z_STREAM_END || zs.avail_out!=0) msg="BGZF: corrupt block.";
+			else if(crc32(crc32(0,NULL,0),(const Bytef*)&out[outOff[i]],sz)!=getLE32(b+offsets[i+1]-8)) msg="BGZF: CRC mismatch.";
+			if(msg){
+				#ifdef WOO_OPENMP
+					#pragma omp critical
+				#endif
+				err=msg;
+			}
+		}
+		if(ok) inflateEnd(&zs);
+		else{
+			#ifdef WOO_OPENMP
+				#pragma omp critical
+			#endif
+			err="BGZF: inflateInit2 failed.";
+		}
+	}
+	if(!err.empty()) throw std::runtime_error(err);
+}
+
+}}
@@ -0,0 +1,107 @@
+#pragma once
+#include<string>
+#include<vector>
+#include<cstring>
+#include<stdexcept>
+#include<boost/shared_ptr.hpp>
+#include<boost/make_shared.hpp>
+#include<boost/iostreams/categories.hpp>
+#include<boost/iostreams/operations.hpp>
+
+namespace woo{
+/* Block-parallel gzip compression (BGZF, the format of bgzip/htslib), as boost::iostreams filters.
+
+Data are split into independent gzip members (blocks) of less than 64 kB, each storing its compressed
+size in the 'BC' extra field, so that blocks can be located without decompressing. Blocks are
+(de)compressed in batches, in parallel with OpenMP. The result is a regular multi-member gzip file,
+which can be read by gzip, zcat or bgzip.
+*/
+namespace bgzf{
+	enum{ BLOCK_IN=0xff00 /* uncompressed bytes per block */, BLOCK_MAX=0x10000, HEADER=18, FOOTER=8 };
+	// number of blocks (de)compressed at once
+	size_t batchBlocks();
+	// compress in[0…n) into blocks, appended to out
+	void compress(const char* in, size_t n, std::string& out, int level);
+	// total size of the block starting with given header (HEADER bytes); throws if not a BGZF block
+	size_t blockSize(const unsigned char* hdr);
+	// decompress complete blocks stored in blocks, starting at offsets (with the end as the last item); output appended to out
+	void decompress(const std::string& blocks, const std::vector<size_t>& offsets, std::string& out);
+	// empty block marking end of file
+	extern const char eofBlock[28];
+}
+
+class bgzf_compressor{
+	struct Impl{ std::string buf, out; int level; };
+	boost::shared_ptr<Impl> impl;
+	template<typename Sink> void flushBlocks(Sink& snk, bool all){
+		std::string& buf(impl->buf);
+		size_t n=(all?buf.size():(buf.size()/bgzf::BLOCK_IN)*bgzf::BLOCK_IN);
+		if(n==0) return;
+		impl->out.clear();
+		bgzf::compress(buf.data(),n,impl->out,impl->level);
+		boost::iostreams::write(snk,impl->out.data(),impl->out.size());
+		buf.erase(0,n);
+	}
+	public:
+	typedef char char_type;
+	struct category: boost::iostreams::multichar_output_filter_tag, boost::iostreams::closable_tag{};
+	bgzf_compressor(int level=6): impl(boost::make_shared<Impl>()){ impl->level=level; }
+	template<typename Sink> std::streamsize write(Sink& snk, const char* s, std::streamsize n){
+		impl->buf.append(s,n);
+		if(impl->buf.size()>=bgzf::batchBlocks()*bgzf::BLOCK_IN) flushBlocks(snk,/*all*/false);
+		return n;
+	}
+	template<typename Sink> void close(Sink& snk){
+		flushBlocks(snk,/*all*/true);
+		boost::iostreams::write(snk,bgzf::eofBlock,sizeof(bgzf::eofBlock));
+	}
+};
+
+class bgzf_decompressor{
+	struct Impl{ std::string blocks, out; std::vector<size_t> offsets; size_t pos; bool eof; };
+	boost::shared_ptr<Impl> impl;
+	template<typename Source> static std::streamsize readFull(Source& src, char* s, std::streamsize n){
+		std::streamsize r=0;
+		while(r<n){
+			std::streamsize k=boost::iostreams::read(src,s+r,n-r);
+			if(k<=0) break;
+			r+=k;
+		}
+		return r;
+	}
+	// read the next batch of blocks and decompress them
+	template<typename Source> void refill(Source& src){
+		impl->blocks.clear(); impl->offsets.assign(1,0); impl->out.clear(); impl->pos=0;
+		const size_t nMax=bgzf::batchBlocks();
+		while(impl->offsets.size()<=nMax){
+			unsigned char hdr[bgzf::HEADER];
+			std::streamsize r=readFull(src,(char*)hdr,bgzf::HEADER);
+			if(r==0){ impl->eof=true; break; }
+			if(r<bgzf::HEADER) throw std::runtime_error("BGZF: truncated block header.");
+			const size_t sz=bgzf::blockSize(hdr);
+			const size_t off=impl->blocks.size();
+			impl->blocks.resize(off+sz);
+			memcpy(&impl->blocks[off],hdr,bgzf::HEADER);
+			if(readFull(src,&impl->blocks[off+bgzf::HEADER],sz-bgzf::HEADER)!=(std::streamsize)(sz-bgzf::HEADER)) throw std::runtime_error("BGZF: truncated block.");
+			impl->offsets.push_back(off+sz);
+		}
+		bgzf::decompress(impl->blocks,impl->offsets,impl->out);
+	}
+	public:
+	typedef char char_type;
+	struct category: boost::iostreams::multichar_input_filter_tag{};
+	bgzf_decompressor(): impl(boost::make_shared<Impl>()){ impl->pos=0; impl->eof=false; }
+	template<typename Source> std::streamsize read(Source& src, char* s, std::streamsize n){
+		// blocks may be empty (such as the EOF block), hence loop
+		while(impl->pos==impl->out.size()){
+			if(impl->eof) return -1;
+			refill(src);
+		}
+		std::streamsize k=std::min((std::streamsize)(impl->out.size()-impl->pos),n);
+		memcpy(s,impl->out.data()+impl->pos,k);
+		impl->pos+=k;
+		return k;
+	}
+};
+
+}
@@ -8,6 +8,7 @@
 #include<boost/iostreams/filter/bzip2.hpp>
 #include<boost/iostreams/filter/gzip.hpp>
 #include<boost/iostreams/device/file.hpp>
+#include<woo/lib/object/Bgzf.hpp>
 #include<boost/algorithm/string.hpp>
 #include<boost/filesystem/operations.hpp>
 #include<boost/version.hpp>
@@ -25,7 +26,18 @@ namespace woo{
 struct ObjectIO{
 	// tell whether given filename looks like XML
 	static bool isXmlFilename(const std::string f){
-		return boost::algorithm::ends_with(f,".xml") || boost::algorithm::ends_with(f,".xml.bz2") || boost::algorithm::ends_with(f,".xml.gz");
+		return boost::algorithm::ends_with(f,".xml") || boost::algorithm::ends_with(f,".xml.bz2") || boost::algorithm::ends_with(f,".xml.gz") || boost::algorithm::ends_with(f,".xml.bgz");
+	}
+	// push (de)compression filter based on file extension: .bz2, .gz, or .bgz (block-parallel gzip)
+	static void pushCompressor(boost::iostreams::filtering_ostream& out, const string& fileName){
+		if(boost::algorithm::ends_with(fileName,".bz2")) out.push(boost::iostreams::bzip2_compressor());
+		if(boost::algorithm::ends_with(fileName,".gz")) out.push(boost::iostreams::gzip_compressor());
+		if(boost::algorithm::ends_with(fileName,".bgz")) out.push(woo::bgzf_compressor());
+	}
+	static void pushDecompressor(boost::iostreams::filtering_istream& in, const string& fileName){
+		if(boost::algorithm::ends_with(fileName,".bz2")) in.push(boost::iostreams::bzip2_decompressor());
+		if(boost::algorithm::ends_with(fileName,".gz")) in.push(boost::iostreams::gzip_decompressor());
+		if(boost::algorithm::ends_with(fileName,".bgz")) in.push(woo::bgzf_decompressor());
 	}
 	// save to given stream and archive format
 	template<class T, class oarchive>
@@ -50,8 +62,7 @@ struct ObjectIO{
 	template<class T>
 	static void save(const string& fileName, const string& objectTag, T& object){
 		boost::iostreams::filtering_ostream out;
-		if(boost::algorithm::ends_with(fileName,".bz2")) out.push(boost::iostreams::bzip2_compressor());
-		if(boost::algorithm::ends_with(fileName,".gz")) out.push(boost::iostreams::gzip_compressor());
+		pushCompressor(out,fileName);
 		// write to a temporary, then rename; this avoids incompletely written files (e.g. when interrupted externally)
 		string tmp=fileName+".~woo~tmp~";
 		boost::iostreams::file_sink outSink(tmp,std::ios_base::out|std::ios_base::binary);
@@ -66,6 +77,8 @@ struct ObjectIO{
 			#endif
 		}
 		else save<T,boost::archive::binary_oarchive>(out,objectTag,object);
+		// flush and close the chain (compressors write their trailing data) before renaming
+		out.reset();
 		// rename to the file requested;
 		// see http://stackoverflow.com/questions/7054844/is-rename-atomic
 		boost::filesystem::rename(tmp,fileName);
@@ -74,8 +87,7 @@ struct ObjectIO{
 	template<class T>
 	static void load(const string& fileName, const string& objectTag, T& object){
 		boost::iostreams::filtering_istream in;
-		if(boost::algorithm::ends_with(fileName,".bz2")) in.push(boost::iostreams::bzip2_decompressor());
-		if(boost::algorithm::ends_with(fileName,".gz")) in.push(boost::iostreams::gzip_decompressor());
+		pushDecompressor(in,fileName);
 		boost::iostreams::file_source inSource(fileName,std::ios_base::in|std::ios_base::binary);
 		if(!inSource.is_open()) throw std::runtime_error("Error opening file "+fileName+" for reading.");
 		in.push(inSource);
@@ -0,0 +1,175 @@
+#include<woo/pkg/dem/CheckpointSaver.hpp>
+#include<woo/lib/object/ObjectIO.hpp>
+#include<woo/lib/pyutil/gil.hpp>
+#include<boost/thread/thread.hpp>
+#include<boost/thread/condition_variable.hpp>
+#include<deque>
+
+WOO_PLUGIN(dem,(CheckpointSaver));
+WOO_IMPL_LOGGER(CheckpointSaver);
+WOO_IMPL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_CheckpointSaver__CLASS_BASE_DOC_ATTRS_PY);
+
+struct CheckpointSaver::Job{
+	// either columnar snapshot, or serialized data
+	shared_ptr<ColumnarCheckpoint::Snapshot> snap;
+	string base; // write delta against this checkpoint, if not empty
+	string data;
+	string out;
+	size_t nBytes;
+	Real t0; // when the snapshot was started
+};
+
+struct CheckpointSaver::Worker{
+	boost::mutex mutex;
+	boost::condition_variable cond;
+	// jobs[0] is being written when busy
+	std::deque<Job> jobs;
+	bool busy, stop;
+	std::atomic<size_t> progress;
+	// results of written jobs, collected by CheckpointSaver::collect
+	long nSaved;
+	string lastOut, error;
+	Real writeTime, latency;
+	boost::thread thread;
+	Worker(): busy(false), stop(false), progress(0), nSaved(0), writeTime(NaN), latency(NaN){ thread=boost::thread([this](){ loop(); }); }
+	~Worker(){
+		{ boost::mutex::scoped_lock l(mutex); stop=true; }
+		cond.notify_all();
+		thread.join();
+	}
+	static void writeData(const Job& job, std::atomic<size_t>& progress){
+		boost::iostreams::filtering_ostream os;
+		woo::ObjectIO::pushCompressor(os,job.out);
+		const string tmp=job.out+".~woo~tmp~";
+		boost::iostreams::file_sink sink(tmp,std::ios_base::out|std::ios_base::binary);
+		if(!sink.is_open()) throw std::runtime_error("Error opening file "+tmp+" for writing.");
+		os.push(sink);
+		const size_t chunk=1<<22;
+		for(size_t o=0; o<job.data.size(); o+=chunk){
+			const size_t n=std::min(chunk,job.data.size()-o);
+			os.write(job.data.data()+o,n);
+			progress+=n;
+		}
+		os.reset();
+		boost::filesystem::rename(tmp,job.out);
+	}
+	void loop(){
+		boost::mutex::scoped_lock l(mutex);
+		while(true){
+			while(!stop && jobs.empty()) cond.wait(l);
+			// pending jobs are written even when stopping
+			if(jobs.empty()) return;
+			busy=true; progress=0;
+			const Job& job(jobs.front());
+			l.unlock();
+			string err;
+			const Real tw=PeriodicEngine::getClock();
+			try{
+				if(job.snap && !job.base.empty()) ColumnarCheckpoint::writeDelta(job.snap,job.base,job.out,&progress);
+				else if(job.snap) ColumnarCheckpoint::write(job.snap,job.out,&progress);
+				else writeData(job,progress);
+			} catch(std::exception& e){ err=e.what(); }
+			const Real t1=PeriodicEngine::getClock();
+			l.lock();
+			if(err.empty()){
+				nSaved++; lastOut=job.out; writeTime=t1-tw; latency=t1-job.t0;
+				LOG_DEBUG("Checkpoint "<<job.out<<" written, "<<job.nBytes<<" bytes, latency "<<latency<<"s.");
+			} else {
+				LOG_ERROR("Writing checkpoint "<<job.out<<" failed: "<<err);
+				error=job.out+": "+err;
+			}
+			jobs.pop_front();
+			busy=false;
+			cond.notify_all();
+		}
+	}
+};
+
+void CheckpointSaver::collect(){
+	if(!worker) return;
+	string err;
+	{
+		boost::mutex::scoped_lock l(worker->mutex);
+		nSaved=worker->nSaved; lastOut=worker->lastOut; writeTime=worker->writeTime; latency=worker->latency;
+		err=worker->error; worker->error.clear();
+	}
+	if(!err.empty()) throw std::runtime_error("CheckpointSaver: "+err);
+}
+
+void CheckpointSaver::flush(){
+	if(!worker) return;
+	{
+		boost::mutex::scoped_lock l(worker->mutex);
+		while(!worker->jobs.empty()) worker->cond.wait(l);
+	}
+	collect();
+}
+
+size_t CheckpointSaver::pyPending(){
+	if(!worker) return 0;
+	boost::mutex::scoped_lock l(worker->mutex);
+	return worker->jobs.size();
+}
+
+Real CheckpointSaver::pyProgress(){
+	if(!worker) return NaN;
+	boost::mutex::scoped_lock l(worker->mutex);
+	if(!worker->busy || worker->jobs.empty() || worker->jobs.front().nBytes==0) return NaN;
+	return worker->progress*1./worker->jobs.front().nBytes;
+}
+
+void CheckpointSaver::run(){
+	if(maxPending<1) throw std::runtime_error("CheckpointSaver.maxPending: must be positive (not "+to_string(maxPending)+").");
+	collect();
+	if(!worker) worker=make_shared<Worker>();
+	const Real t0=getClock();
+	{
+		boost::mutex::scoped_lock l(worker->mutex);
+		if((int)worker->jobs.size()>=maxPending){
+			if(!wait){
+				nSkipped++;
+				LOG_WARN("Checkpoint at step "<<scene->step<<" skipped, "<<worker->jobs.size()<<" checkpoint(s) still being written (increase CheckpointSaver.maxPending, or set CheckpointSaver.wait).");
+				return;
+			}
+			while((int)worker->jobs.size()>=maxPending) worker->cond.wait(l);
+		}
+	}
+	string out2=out;
+	boost::algorithm::replace_all(out2,"{step}",to_string(scene->step));
+	out2=scene->expandTags(out2);
+	scene->lastSave=out2;
+	Job job;
+	job.out=out2; job.t0=t0;
+	{
+		// python objects (e.g. in Scene.labels) are pickled during serialization
+		GilLock lock;
+		shared_ptr<Scene> s(scene,woo::Object::null_deleter());
+		if(columnar){
+			job.snap=ColumnarCheckpoint::snapshot(s);
+			job.nBytes=ColumnarCheckpoint::snapshotSize(job.snap);
+			// deltas are written after their base, since jobs are processed in order
+			if(fullEvery>1 && !lastFull.empty() && sinceFull<fullEvery-1){ job.base=lastFull; sinceFull++; }
+			else { lastFull=out2; sinceFull=0; }
+		} else {
+			std::ostringstream oss;
+			shared_ptr<Object> obj(s);
+			if(woo::ObjectIO::isXmlFilename(out2)){
+				#ifdef WOO_NOXML
+					throw std::runtime_error("Serialization to XML is not supported in this build of Woo (recompile without the 'noxml' feature).");
+				#else
+					woo::ObjectIO::save<shared_ptr<Object>,boost::archive::xml_oarchive>(oss,"woo__Object",obj);
+				#endif
+			}
+			else woo::ObjectIO::save<shared_ptr<Object>,boost::archive::binary_oarchive>(oss,"woo__Object",obj);
+			job.data=oss.str();
+			job.nBytes=job.data.size();
+		}
+	}
+	lastSize=job.nBytes;
+	snapshotTime=getClock()-t0;
+	{
+		boost::mutex::scoped_lock l(worker->mutex);
+		worker->jobs.push_back(std::move(job));
+	}
+	worker->cond.notify_all();
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include<woo/core/Engine.hpp>
+#include<woo/pkg/dem/ColumnarCheckpoint.hpp>
+
+/*
+Periodic checkpoints written in the background.
+
+The simulation thread only takes a snapshot of the scene: ColumnarCheckpoint::snapshot copies DEM
+state into columns (serializing the rest into memory), or the whole scene is serialized into memory
+when boost::serialization format is used. Compression and writing to disk are done by a worker
+thread, while the simulation goes on. At most maxPending snapshots are kept in memory; when the
+limit is reached, the checkpoint is skipped (or the engine waits, with wait=True).
+*/
+struct CheckpointSaver: public PeriodicEngine{
+	WOO_DECL_LOGGER;
+	bool needsField() WOO_CXX11_OVERRIDE { return false; }
+	void run() WOO_CXX11_OVERRIDE;
+	// wait until all pending checkpoints are written
+	void flush();
+	private:
+	struct Job;
+	struct Worker;
+	// background thread, created at the first run; pending checkpoints are written before it is destroyed
+	shared_ptr<Worker> worker;
+	// copy statistics from the worker; rethrow errors from the worker
+	void collect();
+	size_t pyPending();
+	Real pyProgress();
+	public:
+	#define woo_dem_CheckpointSaver__CLASS_BASE_DOC_ATTRS_PY \
+		CheckpointSaver,PeriodicEngine,"Save checkpoints periodically, without stalling the simulation for compression and writing: the scene is only copied (snapshot) in the simulation thread, then written by a background thread. With :obj:`columnar`, DEM particles and contacts are copied as arrays (see :obj:`ColumnarCheckpoint`), otherwise the scene is serialized into memory. Memory is bounded by :obj:`maxPending`. Call :obj:`flush` to wait for all checkpoints to be written (e.g. before the process exits).", \
+		((string,out,"{tid}-{step}.wooc",,"Output file name; ``{step}`` is replaced by :obj:`Scene.step`, other ``{tags}`` are expanded from :obj:`Scene.tags`; ``.gz``, ``.bgz`` (block-parallel gzip, compressed with all threads) or ``.bz2`` extension compresses the output.")) \
+		((bool,columnar,true,,"Use :obj:`ColumnarCheckpoint` format (load with :obj:`ColumnarCheckpoint.load` or :obj:`woo.core.Object.load`); if false, the usual boost::serialization format is written (binary, or XML if :obj:`out` says so).")) \
+		((int,fullEvery,0,,"With :obj:`columnar`, write only every *fullEvery*-th checkpoint in full, and others as deltas against the last full one (see :obj:`ColumnarCheckpoint.saveDelta`); values smaller than 2 write all checkpoints in full.")) \
+		((int,maxPending,1,,"Maximum number of snapshots kept in memory (being written, or waiting to be written).")) \
+		((bool,wait,false,,"When :obj:`maxPending` snapshots are in memory already, wait for the oldest one to be written; if false, the checkpoint is skipped instead.")) \
+		((long,nSaved,0,AttrTrait<Attr::readonly>(),"Number of checkpoints written.")) \
+		((long,nSkipped,0,AttrTrait<Attr::readonly>(),"Number of checkpoints skipped, because too many snapshots were pending.")) \
+		((string,lastOut,"",AttrTrait<Attr::readonly>(),"Name of the last checkpoint written.")) \
+		((string,lastFull,"",AttrTrait<Attr::readonly>(),"Name of the last full checkpoint, which is the base of deltas (with :obj:`fullEvery`).")) \
+		((int,sinceFull,0,AttrTrait<Attr::readonly>(),"Number of deltas since the last full checkpoint.")) \
+		((size_t,lastSize,0,AttrTrait<Attr::readonly>(),"Uncompressed size of the last snapshot, in bytes.")) \
+		((Real,snapshotTime,NaN,AttrTrait<Attr::readonly>().timeUnit(),"Time the simulation was stopped for the last snapshot (including waiting, with :obj:`wait`).")) \
+		((Real,writeTime,NaN,AttrTrait<Attr::readonly>().timeUnit(),"Time spent by writing (and compressing) the last checkpoint written.")) \
+		((Real,latency,NaN,AttrTrait<Attr::readonly>().timeUnit(),"Time between the beginning of the snapshot and the checkpoint file being complete, for the last checkpoint written.")) \
+		,/*py*/ \
+		.def("flush",&CheckpointSaver::flush,"Wait until all pending checkpoints are written.") \
+		.add_property("pending",&CheckpointSaver::pyPending,"Number of snapshots not yet written.") \
+		.add_property("progress",&CheckpointSaver::pyProgress,"Fraction of the checkpoint currently being written (NaN if nothing is being written).")
+	WOO_DECL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_CheckpointSaver__CLASS_BASE_DOC_ATTRS_PY);
+};
+WOO_REGISTER_OBJECT(CheckpointSaver);
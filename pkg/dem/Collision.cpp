@@ -42,18 +42,99 @@ bool Collider::mayCollide(const DemField* dem, const shared_ptr<Particle>& pA, c
 
 void BoundDispatcher::run(){
 	updateScenePtr();
-	FOREACH(const shared_ptr<Particle> p, *(field->cast<DemField>().particles)){
-		shared_ptr<Shape>& shape=p->shape;
-		if(!shape) continue;
-		operator()(shape);
-		if(!shape) continue; // the functor did not create new bound
-	#if 0
-		Aabb* aabb=WOO_CAST<Aabb*>(shape->bound.get());
-		Real sweep=velocityBins->bins[velocityBins->bodyBins[p->id]].maxDist;
-		aabb->min-=Vector3r(sweep,sweep,sweep);
-		aabb->max+=Vector3r(sweep,sweep,sweep);
+	// HACK: run serially for the very first time, as in InsertionSortCollider::run (crashes in Aabb ctor otherwise)
+	updateBounds(field->cast<DemField>(),verletDist,lazy,/*noBoundOk*/true,/*parallel*/nRuns>0);
+}
+
+bool BoundDispatcher::boundValid(const Shape& sh){
+	if(!sh.bound || !sh.bound->isA<Aabb>()) return false;
+	const Aabb& aabb=sh.bound->cast<Aabb>();
+	const int nNodes=sh.nodes.size();
+	if((int)aabb.nodeLastPos.size()!=nNodes || (int)aabb.nodeLastOri.size()!=nNodes) return false;
+	if(isnan(aabb.min.maxCoeff())||isnan(aabb.max.maxCoeff())) return false;
+	// check rotation difference, for particles where it matters
+	Real moveDueToRot2=0.;
+	if(aabb.maxRot>=0.){
+		assert(!isnan(aabb.maxRot));
+		Real maxRot=0.;
+		for(int i=0; i<nNodes; i++){
+			AngleAxisr aa(aabb.nodeLastOri[i].conjugate()*sh.nodes[i]->ori);
+			// moving will decrease the angle, it is taken in account here, with the asymptote
+			// it is perhaps not totally correct... :|
+			maxRot=max(maxRot,abs(aa.angle())); // abs perhaps not needed?
+		}
+		if(maxRot>aabb.maxRot) return false;
+		// linearize here, but don't subtract verletDist
+		moveDueToRot2=pow(.5*(aabb.max-aabb.min).maxCoeff()*maxRot,2);
+	}
+	// check movement
+	Real d2=0;
+	for(int i=0; i<nNodes; i++) d2=max(d2,(aabb.nodeLastPos[i]-sh.nodes[i]->pos).squaredNorm());
+	return d2+moveDueToRot2<=aabb.maxD2;
+}
+
+void BoundDispatcher::updateBound(const shared_ptr<Particle>& p, Real verletDist, bool noBoundOk){
+	operator()(p->shape);
+	if(!p->shape->bound){
+		if(noBoundOk) return;
+		throw std::runtime_error("No bound was created for #"+lexical_cast<string>(p->id)+", provide a Bo1_*_Aabb functor for it. (Particle without Aabb are not supported yet, and perhaps will never be (what is such a particle good for?!)");
+	}
+	Aabb& aabb=p->shape->bound->cast<Aabb>();
+	const int nNodes=p->shape->nodes.size();
+	// save reference node positions
+	aabb.nodeLastPos.resize(nNodes);
+	aabb.nodeLastOri.resize(nNodes);
+	for(int i=0; i<nNodes; i++){
+		aabb.nodeLastPos[i]=p->shape->nodes[i]->pos;
+		aabb.nodeLastOri[i]=p->shape->nodes[i]->ori;
+	}
+	aabb.maxD2=pow(verletDist,2);
+	if(isnan(aabb.maxRot)) throw std::runtime_error("S.dem.par["+to_string(p->id)+"]: bound functor did not set maxRot -- should be set to either to a negative value (to ignore it) or to non-negative value (maxRot will be set from verletDist in that case); this is an implementation error.");
+	if(verletDist>0){
+		if(aabb.maxRot>=0){
+			// maximum rotation arm, assume centroid in the middle
+			Real maxArm=.5*(aabb.max-aabb.min).maxCoeff();
+			if(maxArm>0.) aabb.maxRot=atan(verletDist/maxArm); // FIXME: this may be very slow...?
+			else aabb.maxRot=0.;
+		}
+		aabb.max+=verletDist*Vector3r::Ones();
+		aabb.min-=verletDist*Vector3r::Ones();
+	}
+}
+
+size_t BoundDispatcher::updateBounds(DemField& dem, Real verletDist, bool lazy, bool noBoundOk, bool parallel){
+	const ParticleContainer& particles(*dem.particles);
+	const size_t size=particles.size();
+	string err;
+	#ifdef WOO_OPENMP
+		vector<vector<int>> thDirty(omp_get_max_threads());
+		#pragma omp parallel for schedule(guided) num_threads(parallel?omp_get_max_threads():1)
+	#else
+		vector<vector<int>> thDirty(1);
 	#endif
+	for(size_t i=0; i<size; i++){
+		const shared_ptr<Particle>& p(particles[i]);
+		if(!p || !p->shape) continue;
+		if(lazy && boundValid(*p->shape)) continue;
+		try{ updateBound(p,verletDist,noBoundOk); }
+		catch(std::exception& e){
+			#ifdef WOO_OPENMP
+				#pragma omp critical(boundDispatcherErr)
+			#endif
+			{ if(err.empty()) err=e.what(); }
+		}
+		#ifdef WOO_OPENMP
+			thDirty[omp_get_thread_num()].push_back(i);
+		#else
+			thDirty[0].push_back(i);
+		#endif
 	}
+	if(!err.empty()) throw std::runtime_error(err);
+	dirty.clear();
+	for(const auto& d: thDirty) dirty.insert(dirty.end(),d.begin(),d.end());
+	std::sort(dirty.begin(),dirty.end());
+	nRuns++;
+	return dirty.size();
 }
 
 #ifdef WOO_OPENGL
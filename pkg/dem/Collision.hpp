@@ -42,8 +42,18 @@ WOO_REGISTER_OBJECT(BoundFunctor);
 
 struct BoundDispatcher: public Dispatcher1D</* functor type*/ BoundFunctor>{
 	void run() WOO_CXX11_OVERRIDE;
+	// whether Aabb of this shape is still valid, i.e. nodes did not move/rotate more than allowed by Aabb::maxD2 and Aabb::maxRot
+	static bool boundValid(const Shape& sh);
+	// (re)create bound of one particle, save reference node positions and enlarge it by verletDist
+	void updateBound(const shared_ptr<Particle>& p, Real verletDist, bool noBoundOk);
+	/* update bounds of all particles (only invalid ones if lazy) in parallel, fill dirty with ids of updated particles (in ascending order) and return their number; exceptions from single particles are re-thrown after the loop */
+	size_t updateBounds(DemField& dem, Real verletDist, bool lazy, bool noBoundOk, bool parallel=true);
+	long nRuns=0;
 	WOO_DISPATCHER1D_FUNCTOR_DOC_ATTRS_CTOR_PY(BoundDispatcher,BoundFunctor,/*optional doc*/,
 		/*additional attrs*/
+		((Real,verletDist,0,AttrTrait<>().lenUnit(),"Length by which bounds are enlarged when run as standalone engine (colliders pass their own value)."))
+		((bool,lazy,true,,"When run as standalone engine, only update bounds of particles which moved or rotated more than allowed by their :obj:`Aabb` (:obj:`Aabb.maxD2`, :obj:`Aabb.maxRot`)."))
+		((vector<int>,dirty,,AttrTrait<Attr::readonly|Attr::noSave>(),"Ids of particles of which bounds were updated by the last run."))
 		,/*ctor*/,/*py*/
 	);
 };
@@ -0,0 +1,754 @@
+#include<woo/pkg/dem/ColumnarCheckpoint.hpp>
+#include<woo/pkg/dem/ParticleContainer.hpp>
+#include<woo/pkg/dem/ContactContainer.hpp>
+#include<woo/pkg/dem/Sphere.hpp>
+#include<woo/pkg/dem/L6Geom.hpp>
+#include<woo/pkg/dem/FrictMat.hpp>
+#include<woo/core/Scene.hpp>
+#include<woo/lib/object/ObjectIO.hpp>
+#include<woo/lib/base/SlabPool.hpp>
+#include<boost/iostreams/stream.hpp>
+#include<boost/iostreams/device/array.hpp>
+#include<boost/iostreams/copy.hpp>
+#include<boost/iostreams/device/mapped_file.hpp>
+#ifdef __linux__
+	#include<sys/mman.h>
+#endif
+#include<cstring>
+#include<typeinfo>
+#include<unordered_map>
+#include<atomic>
+#include<zlib.h>
+#include<functional>
+
+WOO_PLUGIN(dem,(ColumnarCheckpoint));
+WOO_IMPL_LOGGER(ColumnarCheckpoint);
+WOO_IMPL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_ColumnarCheckpoint__CLASS_BASE_DOC_ATTRS_PY);
+
+const char ColumnarCheckpoint::magic[17]="##woo-columnar##";
+const char ColumnarCheckpoint::deltaMagic[17]="##woo-col-delta#";
+
+namespace {
+	typedef ColumnarCheckpoint::Section Section;
+
+	// sections to be written; data are referenced, not copied
+	struct ColumnWriter{
+		vector<Section> sections;
+		vector<const char*> data;
+		void add(const string& name, const void* ptr, size_t itemSize, size_t count, bool detectConst=true){
+			Section s; memset(&s,0,sizeof(s));
+			if(name.size()>=sizeof(s.name)) throw std::logic_error("ColumnarCheckpoint: section name "+name+" too long.");
+			strncpy(s.name,name.c_str(),sizeof(s.name)-1);
+			s.itemSize=itemSize; s.count=count; s.flags=0;
+			const char* p=(const char*)ptr;
+			size_t n=count;
+			if(detectConst && count>1){
+				bool same=true;
+				for(size_t i=1; i<count && same; i++) same=(memcmp(p,p+i*itemSize,itemSize)==0);
+				if(same){ s.flags|=ColumnarCheckpoint::SEC_CONST; n=1; }
+			}
+			s.nBytes=n*itemSize;
+			sections.push_back(s);
+			data.push_back(p);
+		}
+		// comp items of v make one row
+		template<typename T> void add(const string& name, const vector<T>& v, int comp=1){ add(name,v.data(),comp*sizeof(T),v.size()/comp); }
+		// compute offsets of all sections; returns the total size
+		uint64_t layout(){
+			const size_t A=ColumnarCheckpoint::ALIGN;
+			uint64_t off=sizeof(ColumnarCheckpoint::Header)+sections.size()*sizeof(Section);
+			for(Section& s: sections){ off=(off+A-1)/A*A; s.offset=off; off+=s.nBytes; }
+			return off;
+		}
+		// progress (if given) is incremented by the number of bytes written
+		void write(std::ostream& os, std::atomic<size_t>* progress=NULL, const char* magic=ColumnarCheckpoint::magic){
+			ColumnarCheckpoint::Header h; memset(&h,0,sizeof(h));
+			memcpy(h.magic,magic,sizeof(h.magic));
+			h.version=ColumnarCheckpoint::VERSION; h.endian=ColumnarCheckpoint::ENDIAN; h.realSize=sizeof(Real); h.nSections=sections.size();
+			layout();
+			os.write((const char*)&h,sizeof(h));
+			os.write((const char*)sections.data(),sections.size()*sizeof(Section));
+			uint64_t pos=sizeof(h)+sections.size()*sizeof(Section);
+			if(progress) *progress+=pos;
+			const char zeros[ColumnarCheckpoint::ALIGN]={0};
+			const uint64_t chunk=1<<22;
+			for(size_t i=0; i<sections.size(); i++){
+				os.write(zeros,sections[i].offset-pos);
+				if(progress) *progress+=sections[i].offset-pos;
+				for(uint64_t o=0; o<sections[i].nBytes; o+=chunk){
+					const uint64_t n=std::min(chunk,sections[i].nBytes-o);
+					os.write(data[i]+o,n);
+					if(progress) *progress+=n;
+				}
+				pos=sections[i].offset+sections[i].nBytes;
+			}
+		}
+	};
+
+	struct ColumnReader{
+		const char* buf; size_t size;
+		std::map<string,const Section*> secs;
+		ColumnReader(const char* _buf, size_t _size, const char* magic=ColumnarCheckpoint::magic): buf(_buf), size(_size){
+			const ColumnarCheckpoint::Header& h(*(const ColumnarCheckpoint::Header*)buf);
+			if(size<sizeof(h) || memcmp(h.magic,magic,sizeof(h.magic))!=0) throw std::runtime_error(string("ColumnarCheckpoint: not a columnar ")+(magic==ColumnarCheckpoint::deltaMagic?"delta ":"")+"checkpoint.");
+			if(h.version!=ColumnarCheckpoint::VERSION) throw std::runtime_error("ColumnarCheckpoint: unsupported version "+to_string(h.version)+" (only "+to_string((int)ColumnarCheckpoint::VERSION)+" is supported).");
+			if(h.endian!=ColumnarCheckpoint::ENDIAN) throw std::runtime_error("ColumnarCheckpoint: saved on a machine with different byte order.");
+			if(h.realSize!=sizeof(Real)) throw std::runtime_error("ColumnarCheckpoint: saved with sizeof(Real)="+to_string(h.realSize)+", but this build has "+to_string(sizeof(Real))+".");
+			if(size<sizeof(h)+h.nSections*sizeof(Section)) throw std::runtime_error("ColumnarCheckpoint: truncated file (section table).");
+			const Section* s=(const Section*)(buf+sizeof(h));
+			for(size_t i=0; i<h.nSections; i++){
+				if(s[i].offset+s[i].nBytes>size) throw std::runtime_error("ColumnarCheckpoint: truncated file (section "+string(s[i].name)+").");
+				secs[string(s[i].name)]=&s[i];
+			}
+		}
+		const Section& sec(const string& name) const {
+			auto I=secs.find(name);
+			if(I==secs.end()) throw std::runtime_error("ColumnarCheckpoint: section "+name+" missing.");
+			return *I->second;
+		}
+		const char* data(const Section& s) const { return buf+s.offset; }
+		const Section* find(const string& name) const { auto I=secs.find(name); return I==secs.end()?NULL:I->second; }
+		template<typename T> struct Col{
+			const T* p; size_t comp; bool cnst;
+			const T& operator()(size_t i, size_t k=0) const { return p[(cnst?0:i*comp)+k]; }
+		};
+		template<typename T> Col<T> col(const string& name, size_t count, int comp=1) const {
+			const Section& s=sec(name);
+			if(s.itemSize!=comp*sizeof(T)) throw std::runtime_error("ColumnarCheckpoint: section "+name+" has item size "+to_string(s.itemSize)+" (expected "+to_string(comp*sizeof(T))+").");
+			if(s.count!=count) throw std::runtime_error("ColumnarCheckpoint: section "+name+" has "+to_string(s.count)+" items (expected "+to_string(count)+").");
+			if(count>0 && s.nBytes<((s.flags&ColumnarCheckpoint::SEC_CONST)?1:count)*s.itemSize) throw std::runtime_error("ColumnarCheckpoint: section "+name+" too short.");
+			Col<T> ret; ret.p=(const T*)data(s); ret.comp=comp; ret.cnst=(s.flags&ColumnarCheckpoint::SEC_CONST); return ret;
+		}
+	};
+
+	// columns of one DemField
+	struct DemColumns{
+		// particles (one node per particle)
+		vector<Particle::id_t> parIds;
+		vector<int32_t> id, mat;
+		vector<uint32_t> mask, flags;
+		vector<int64_t> nodeIx;
+		vector<Real> color, radius, pos, ori, vel, angVel, mass, inertia, force, torque, angMom;
+		// positions of other nodes (stored by boost) in DemField.nodes
+		vector<int64_t> nodeRest, nodeTotal;
+		// contacts
+		vector<size_t> conIx;
+		vector<int64_t> cLinIx;
+		vector<int32_t> cIds, cCellDist, cStepCreated, cStepLastSeen;
+		vector<uint8_t> cReal;
+		vector<Real> cMinDist00Sq, gPos, gOri, gVel, gAngVel, gUN, gLens, gContA, gTrsf, phForce, phTorque, phTanPhi, phKn, phKt;
+		vector<int64_t> conRest, conTotal;
+
+		// objects which can't be stored in columns: counted by reason, for the report
+		size_t parType=0, parShared=0, conType=0, conShared=0;
+		/* Whether an object goes to columns: COL_TYPE if its type or content is not covered by the columns,
+		COL_SHARED if it could be stored in columns, but is referenced from elsewhere (engines, python, clumps),
+		which only boost::serialization restores as the same object. */
+		enum{ COL_OK=0, COL_TYPE, COL_SHARED };
+		static int contactKind(const shared_ptr<Contact>& C){
+			if(!C || C->data || C->pA.expired() || C->pB.expired()) return COL_TYPE;
+			// contacts awaiting removal by the collider are also in ContactContainer.threadsPending (serialized by boost)
+			if(!C->geom && !C->phys) return (C.use_count()>3?COL_SHARED:COL_OK);
+			if(!C->geom || !C->phys) return COL_TYPE;
+			if(typeid(*C->geom)!=typeid(L6Geom) || typeid(*C->phys)!=typeid(FrictPhys)) return COL_TYPE;
+			const shared_ptr<Node>& n(C->geom->node);
+			if(!n || !n->data.empty() || n->rep) return COL_TYPE;
+			// referenced only by ContactContainer.linView and by both particles
+			if(C.use_count()>3 || C->geom.use_count()!=1 || C->phys.use_count()!=1 || n.use_count()!=1) return COL_SHARED;
+			return COL_OK;
+		}
+		static int particleKind(const shared_ptr<Particle>& p, const DemField& dem){
+			if(!p || p->matState || !p->material || !p->shape) return COL_TYPE;
+			if(typeid(*p->shape)!=typeid(Sphere) || p->shape->nodes.size()!=1) return COL_TYPE;
+			const shared_ptr<Node>& n(p->shape->nodes[0]);
+			if(!n || n->rep || !n->hasData<DemData>()) return COL_TYPE;
+			for(size_t i=0; i<n->data.size(); i++){ if(i!=(size_t)Node::ST_DEM && n->data[i]) return COL_TYPE; }
+			const shared_ptr<NodeData>& nd(n->data[Node::ST_DEM]);
+			if(typeid(*nd)!=typeid(DemData)) return COL_TYPE;
+			const DemData& dyn(nd->cast<DemData>());
+			if(dyn.impose || !dyn.master.expired() || dyn.parRef.size()!=1 || !dyn.isNoClump()) return COL_TYPE;
+			// referenced by ParticleContainer, Shape.nodes and by DemField.nodes if there
+			const bool inNodes=(dyn.linIx>=0 && dyn.linIx<(long)dem.nodes.size() && dem.nodes[dyn.linIx]==n);
+			if(p.use_count()!=1 || p->shape.use_count()!=1 || nd.use_count()!=1 || n.use_count()!=(inNodes?2:1)) return COL_SHARED;
+			return COL_OK;
+		}
+
+		void gather(DemField& dem, vector<shared_ptr<Material>>& materials, std::unordered_map<Material*,int>& matIx){
+			const auto& linView(dem.contacts->linView);
+			const long nCon=linView.size();
+			vector<char> conKind(nCon);
+			#ifdef WOO_OPENMP
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(long i=0; i<nCon; i++) conKind[i]=contactKind(linView[i]);
+			const long nPar=dem.particles->size();
+			vector<char> parKind(nPar,COL_OK);
+			#ifdef WOO_OPENMP
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(long i=0; i<nPar; i++) parKind[i]=particleKind(dem.particles->parts[i],dem);
+			// particles in contacts stored by boost must be stored by boost as well (weak_ptr references)
+			for(long i=0; i<nCon; i++){
+				if(conKind[i]==COL_OK) continue;
+				const shared_ptr<Contact>& C(linView[i]);
+				for(const auto& w: {C->pA,C->pB}){ Particle* q=w.lock().get(); if(q && parKind[q->id]==COL_OK) parKind[q->id]=COL_SHARED; }
+			}
+			for(long i=0; i<nPar; i++){
+				if(!dem.particles->parts[i]) continue; // removed particle, nothing to store
+				switch(parKind[i]){ case COL_OK: parIds.push_back(i); break; case COL_TYPE: parType++; break; default: parShared++; }
+			}
+			for(long i=0; i<nCon; i++){
+				if(conKind[i]==COL_OK){ conIx.push_back(i); continue; }
+				conRest.push_back(i);
+				if(conKind[i]==COL_TYPE) conType++; else conShared++;
+			}
+			conTotal.assign(1,nCon);
+			// materials are shared, hence collected serially
+			const long N=parIds.size();
+			mat.resize(N);
+			for(long i=0; i<N; i++){
+				Material* m=dem.particles->parts[parIds[i]]->material.get();
+				auto I=matIx.find(m);
+				if(I!=matIx.end()){ mat[i]=I->second; continue; }
+				mat[i]=matIx[m]=materials.size();
+				materials.push_back(dem.particles->parts[parIds[i]]->material);
+			}
+			id.resize(N); mask.resize(N); flags.resize(N); nodeIx.resize(N);
+			color.resize(N); radius.resize(N); pos.resize(3*N); ori.resize(4*N); vel.resize(3*N); angVel.resize(3*N); mass.resize(N); inertia.resize(3*N); force.resize(3*N); torque.resize(3*N); angMom.resize(3*N);
+			vector<char> nodeCol(dem.nodes.size(),0);
+			#ifdef WOO_OPENMP
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(long i=0; i<N; i++){
+				const Particle& p(*dem.particles->parts[parIds[i]]);
+				Node& n(*p.shape->nodes[0]);
+				const DemData& dyn(n.getData<DemData>());
+				id[i]=p.id; mask[i]=p.mask; flags[i]=dyn.flags;
+				const bool inNodes=(dyn.linIx>=0 && dyn.linIx<(long)dem.nodes.size() && dem.nodes[dyn.linIx].get()==&n);
+				nodeIx[i]=(inNodes?dyn.linIx:-1);
+				if(inNodes) nodeCol[dyn.linIx]=1;
+				color[i]=p.shape->color; radius[i]=p.shape->cast<Sphere>().radius;
+				mass[i]=dyn.mass;
+				for(int k:{0,1,2}){
+					pos[3*i+k]=n.pos[k]; vel[3*i+k]=dyn.vel[k]; angVel[3*i+k]=dyn.angVel[k]; inertia[3*i+k]=dyn.inertia[k];
+					force[3*i+k]=dyn.force[k]; torque[3*i+k]=dyn.torque[k]; angMom[3*i+k]=dyn.angMom[k];
+				}
+				for(int k:{0,1,2,3}) ori[4*i+k]=n.ori.coeffs()[k];
+			}
+			for(size_t i=0; i<dem.nodes.size(); i++){ if(!nodeCol[i]) nodeRest.push_back(i); }
+			nodeTotal.assign(1,dem.nodes.size());
+			// contacts
+			const long M=conIx.size();
+			cLinIx.resize(M); cIds.resize(2*M); cCellDist.resize(3*M); cStepCreated.resize(M); cStepLastSeen.resize(M); cReal.resize(M); cMinDist00Sq.resize(M);
+			// geometry and physics only have rows for real contacts (potential ones are usually the majority)
+			vector<long> gRow(M); long R=0;
+			for(long i=0; i<M; i++) gRow[i]=(linView[conIx[i]]->geom?R++:-1);
+			gPos.resize(3*R); gOri.resize(4*R); gVel.resize(3*R); gAngVel.resize(3*R); gUN.resize(R); gLens.resize(2*R); gContA.resize(R); gTrsf.resize(9*R);
+			phForce.resize(3*R); phTorque.resize(3*R); phTanPhi.resize(R); phKn.resize(R); phKt.resize(R);
+			#ifdef WOO_OPENMP
+				#pragma omp parallel for schedule(static)
+			#endif
+			for(long j=0; j<M; j++){
+				const Contact& C(*linView[conIx[j]]);
+				cLinIx[j]=conIx[j];
+				cIds[2*j]=C.leakPA()->id; cIds[2*j+1]=C.leakPB()->id;
+				for(int k:{0,1,2}) cCellDist[3*j+k]=C.cellDist[k];
+				cStepCreated[j]=C.stepCreated; cStepLastSeen[j]=C.stepLastSeen; cMinDist00Sq[j]=C.minDist00Sq;
+				cReal[j]=(gRow[j]>=0);
+				if(gRow[j]<0) continue;
+				const long i=gRow[j];
+				const L6Geom& g(C.geom->cast<L6Geom>());
+				const FrictPhys& ph(C.phys->cast<FrictPhys>());
+				for(int k:{0,1,2}){
+					gPos[3*i+k]=g.node->pos[k]; gVel[3*i+k]=g.vel[k]; gAngVel[3*i+k]=g.angVel[k];
+					phForce[3*i+k]=ph.force[k]; phTorque[3*i+k]=ph.torque[k];
+				}
+				for(int k:{0,1,2,3}) gOri[4*i+k]=g.node->ori.coeffs()[k];
+				for(int k=0; k<9; k++) gTrsf[9*i+k]=g.trsf.data()[k];
+				gLens[2*i]=g.lens[0]; gLens[2*i+1]=g.lens[1];
+				gUN[i]=g.uN; gContA[i]=g.contA;
+				phTanPhi[i]=ph.tanPhi; phKn[i]=ph.kn; phKt[i]=ph.kt;
+			}
+		}
+
+		void addTo(ColumnWriter& w, const string& P) const {
+			w.add(P+"par.id",id); w.add(P+"par.mask",mask); w.add(P+"par.mat",mat); w.add(P+"par.color",color); w.add(P+"par.radius",radius); w.add(P+"par.nodeIx",nodeIx);
+			w.add(P+"node.pos",pos,3); w.add(P+"node.ori",ori,4);
+			w.add(P+"dem.vel",vel,3); w.add(P+"dem.angVel",angVel,3); w.add(P+"dem.mass",mass); w.add(P+"dem.inertia",inertia,3);
+			w.add(P+"dem.force",force,3); w.add(P+"dem.torque",torque,3); w.add(P+"dem.angMom",angMom,3); w.add(P+"dem.flags",flags);
+			w.add(P+"nodes.rest",nodeRest); w.add(P+"nodes.total",nodeTotal);
+			w.add(P+"con.linIx",cLinIx); w.add(P+"con.ids",cIds,2); w.add(P+"con.cellDist",cCellDist,3);
+			w.add(P+"con.stepCreated",cStepCreated); w.add(P+"con.stepLastSeen",cStepLastSeen); w.add(P+"con.minDist00Sq",cMinDist00Sq); w.add(P+"con.real",cReal);
+			w.add(P+"geom.pos",gPos,3); w.add(P+"geom.ori",gOri,4); w.add(P+"geom.vel",gVel,3); w.add(P+"geom.angVel",gAngVel,3);
+			w.add(P+"geom.uN",gUN); w.add(P+"geom.lens",gLens,2); w.add(P+"geom.contA",gContA); w.add(P+"geom.trsf",gTrsf,9);
+			w.add(P+"phys.force",phForce,3); w.add(P+"phys.torque",phTorque,3); w.add(P+"phys.tanPhi",phTanPhi); w.add(P+"phys.kn",phKn); w.add(P+"phys.kt",phKt);
+			w.add(P+"con.rest",conRest); w.add(P+"con.total",conTotal);
+		}
+	};
+
+	// remove columnar objects from DemField while the rest is serialized, put them back when destroyed
+	struct DemStripper{
+		DemField& dem;
+		const DemColumns& cols;
+		vector<shared_ptr<Particle>> parts;
+		vector<shared_ptr<Node>> nodes;
+		ContactContainer::ContainerT linView;
+		DemStripper(DemField& _dem, const DemColumns& _cols): dem(_dem), cols(_cols){
+			parts.reserve(cols.parIds.size());
+			for(const auto& id: cols.parIds){ parts.push_back(shared_ptr<Particle>()); parts.back().swap(dem.particles->parts[id]); }
+			vector<shared_ptr<Node>> rest; rest.reserve(cols.nodeRest.size());
+			for(const auto& i: cols.nodeRest) rest.push_back(dem.nodes[i]);
+			nodes.swap(dem.nodes); dem.nodes.swap(rest);
+			ContactContainer::ContainerT conRest; conRest.reserve(cols.conRest.size());
+			for(const auto& i: cols.conRest) conRest.push_back(dem.contacts->linView[i]);
+			linView.swap(dem.contacts->linView); dem.contacts->linView.swap(conRest);
+		}
+		~DemStripper(){
+			for(size_t i=0; i<parts.size(); i++) dem.particles->parts[cols.parIds[i]].swap(parts[i]);
+			dem.nodes.swap(nodes);
+			dem.contacts->linView.swap(linView);
+		}
+	};
+
+	void restoreDem(DemField& dem, const ColumnReader& r, const string& P, const vector<shared_ptr<Material>>& materials){
+		const size_t N=r.sec(P+"par.id").count;
+		auto id=r.col<int32_t>(P+"par.id",N); auto mask=r.col<uint32_t>(P+"par.mask",N); auto mat=r.col<int32_t>(P+"par.mat",N);
+		auto color=r.col<Real>(P+"par.color",N); auto radius=r.col<Real>(P+"par.radius",N); auto nodeIx=r.col<int64_t>(P+"par.nodeIx",N);
+		auto pos=r.col<Real>(P+"node.pos",N,3); auto ori=r.col<Real>(P+"node.ori",N,4);
+		auto vel=r.col<Real>(P+"dem.vel",N,3); auto angVel=r.col<Real>(P+"dem.angVel",N,3); auto mass=r.col<Real>(P+"dem.mass",N); auto inertia=r.col<Real>(P+"dem.inertia",N,3);
+		auto force=r.col<Real>(P+"dem.force",N,3); auto torque=r.col<Real>(P+"dem.torque",N,3); auto angMom=r.col<Real>(P+"dem.angMom",N,3); auto flags=r.col<uint32_t>(P+"dem.flags",N);
+		const size_t nRest=r.sec(P+"nodes.rest").count;
+		auto nodeRest=r.col<int64_t>(P+"nodes.rest",nRest);
+		const int64_t nodeTotal=r.col<int64_t>(P+"nodes.total",1)(0);
+
+		// check everything which could crash us in the parallel sections
+		auto& parts(dem.particles->parts);
+		if(dem.nodes.size()!=nRest) throw std::runtime_error("ColumnarCheckpoint: "+P+"nodes.rest has "+to_string(nRest)+" items, but there are "+to_string(dem.nodes.size())+" nodes.");
+		vector<shared_ptr<Node>> nodes(nodeTotal);
+		for(size_t i=0; i<nRest; i++){
+			if(nodeRest(i)<0 || nodeRest(i)>=nodeTotal || nodes[nodeRest(i)]) throw std::runtime_error("ColumnarCheckpoint: "+P+"nodes.rest: invalid index.");
+			nodes[nodeRest(i)]=dem.nodes[i];
+		}
+		for(size_t i=0; i<N; i++){
+			if(id(i)<0 || id(i)>=(int)parts.size() || parts[id(i)]) throw std::runtime_error("ColumnarCheckpoint: "+P+"par.id: invalid or duplicate id "+to_string(id(i))+".");
+			if(mat(i)<0 || mat(i)>=(int)materials.size()) throw std::runtime_error("ColumnarCheckpoint: "+P+"par.mat: invalid material index.");
+			if(nodeIx(i)>=nodeTotal || (nodeIx(i)>=0 && nodes[nodeIx(i)])) throw std::runtime_error("ColumnarCheckpoint: "+P+"par.nodeIx: invalid index.");
+		}
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(size_t i=0; i<N; i++){
+			auto p=make_shared<Particle>();
+			auto s=make_shared<Sphere>();
+			auto n=make_shared<Node>();
+			auto dyn=make_shared<DemData>();
+			p->id=id(i); p->mask=mask(i); p->material=materials[mat(i)]; p->shape=s;
+			s->radius=radius(i); s->color=color(i); s->nodes.push_back(n);
+			n->pos=Vector3r(pos(i,0),pos(i,1),pos(i,2));
+			n->ori.coeffs()=Vector4r(ori(i,0),ori(i,1),ori(i,2),ori(i,3));
+			n->setData<DemData>(dyn);
+			dyn->vel=Vector3r(vel(i,0),vel(i,1),vel(i,2));
+			dyn->angVel=Vector3r(angVel(i,0),angVel(i,1),angVel(i,2));
+			dyn->mass=mass(i);
+			dyn->inertia=Vector3r(inertia(i,0),inertia(i,1),inertia(i,2));
+			dyn->force=Vector3r(force(i,0),force(i,1),force(i,2));
+			dyn->torque=Vector3r(torque(i,0),torque(i,1),torque(i,2));
+			dyn->angMom=Vector3r(angMom(i,0),angMom(i,1),angMom(i,2));
+			dyn->flags=flags(i);
+			dyn->linIx=nodeIx(i);
+			dyn->addParRef_raw(p.get());
+			if(nodeIx(i)>=0) nodes[nodeIx(i)]=n;
+			parts[id(i)]=p;
+		}
+		for(const auto& n: nodes){ if(!n) throw std::runtime_error("ColumnarCheckpoint: "+P+": some nodes are missing."); }
+		{
+			boost::mutex::scoped_lock lock(dem.nodesMutex);
+			dem.nodes.swap(nodes);
+		}
+
+		// contacts
+		const size_t M=r.sec(P+"con.linIx").count;
+		auto cLinIx=r.col<int64_t>(P+"con.linIx",M); auto cIds=r.col<int32_t>(P+"con.ids",M,2); auto cCellDist=r.col<int32_t>(P+"con.cellDist",M,3);
+		auto cStepCreated=r.col<int32_t>(P+"con.stepCreated",M); auto cStepLastSeen=r.col<int32_t>(P+"con.stepLastSeen",M); auto cMinDist00Sq=r.col<Real>(P+"con.minDist00Sq",M); auto cReal=r.col<uint8_t>(P+"con.real",M);
+		// rows of geometry and physics (real contacts only)
+		vector<long> gRow(M); size_t R=0;
+		for(size_t i=0; i<M; i++) gRow[i]=(cReal(i)?(long)R++:-1);
+		auto gPos=r.col<Real>(P+"geom.pos",R,3); auto gOri=r.col<Real>(P+"geom.ori",R,4); auto gVel=r.col<Real>(P+"geom.vel",R,3); auto gAngVel=r.col<Real>(P+"geom.angVel",R,3);
+		auto gUN=r.col<Real>(P+"geom.uN",R); auto gLens=r.col<Real>(P+"geom.lens",R,2); auto gContA=r.col<Real>(P+"geom.contA",R); auto gTrsf=r.col<Real>(P+"geom.trsf",R,9);
+		auto phForce=r.col<Real>(P+"phys.force",R,3); auto phTorque=r.col<Real>(P+"phys.torque",R,3); auto phTanPhi=r.col<Real>(P+"phys.tanPhi",R); auto phKn=r.col<Real>(P+"phys.kn",R); auto phKt=r.col<Real>(P+"phys.kt",R);
+		const size_t mRest=r.sec(P+"con.rest").count;
+		auto conRest=r.col<int64_t>(P+"con.rest",mRest);
+		const int64_t conTotal=r.col<int64_t>(P+"con.total",1)(0);
+		auto& cc(*dem.contacts);
+		if(cc.linView.size()!=mRest) throw std::runtime_error("ColumnarCheckpoint: "+P+"con.rest has "+to_string(mRest)+" items, but there are "+to_string(cc.linView.size())+" contacts.");
+		ContactContainer::ContainerT linView(conTotal);
+		for(size_t i=0; i<mRest; i++){
+			if(conRest(i)<0 || conRest(i)>=conTotal || linView[conRest(i)]) throw std::runtime_error("ColumnarCheckpoint: "+P+"con.rest: invalid index.");
+			linView[conRest(i)]=cc.linView[i];
+		}
+		for(size_t i=0; i<M; i++){
+			if(cLinIx(i)<0 || cLinIx(i)>=conTotal || linView[cLinIx(i)]) throw std::runtime_error("ColumnarCheckpoint: "+P+"con.linIx: invalid index.");
+			for(int k:{0,1}){ if(cIds(i,k)<0 || cIds(i,k)>=(int)parts.size() || !parts[cIds(i,k)]) throw std::runtime_error("ColumnarCheckpoint: "+P+"con.ids: particle #"+to_string(cIds(i,k))+" does not exist."); }
+		}
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(size_t i=0; i<M; i++){
+			shared_ptr<Contact> C=woo::slab_make_shared<Contact>();
+			C->pA=parts[cIds(i,0)]; C->pB=parts[cIds(i,1)];
+			C->cellDist=Vector3i(cCellDist(i,0),cCellDist(i,1),cCellDist(i,2));
+			C->stepCreated=cStepCreated(i); C->stepLastSeen=cStepLastSeen(i); C->minDist00Sq=cMinDist00Sq(i);
+			C->linIx=cLinIx(i);
+			if(gRow[i]>=0){
+				const size_t j=gRow[i];
+				auto g=woo::slab_make_shared<L6Geom>();
+				auto ph=woo::slab_make_shared<FrictPhys>();
+				g->node->pos=Vector3r(gPos(j,0),gPos(j,1),gPos(j,2));
+				g->node->ori.coeffs()=Vector4r(gOri(j,0),gOri(j,1),gOri(j,2),gOri(j,3));
+				g->vel=Vector3r(gVel(j,0),gVel(j,1),gVel(j,2));
+				g->angVel=Vector3r(gAngVel(j,0),gAngVel(j,1),gAngVel(j,2));
+				g->uN=gUN(j); g->lens=Vector2r(gLens(j,0),gLens(j,1)); g->contA=gContA(j);
+				for(int k=0; k<9; k++) g->trsf.data()[k]=gTrsf(j,k);
+				ph->force=Vector3r(phForce(j,0),phForce(j,1),phForce(j,2));
+				ph->torque=Vector3r(phTorque(j,0),phTorque(j,1),phTorque(j,2));
+				ph->tanPhi=phTanPhi(j); ph->kn=phKn(j); ph->kt=phKt(j);
+				C->geom=g; C->phys=ph;
+			}
+			linView[C->linIx]=C;
+		}
+		for(const auto& C: linView){ if(!C) throw std::runtime_error("ColumnarCheckpoint: "+P+": some contacts are missing."); }
+		#if defined(WOO_OPENMP) || defined(WOO_OPENGL)
+			boost::mutex::scoped_lock lock(cc.manipMutex);
+		#endif
+		cc.linView.swap(linView);
+		// contacts stored by boost were added to particles in DemField::postLoad already
+		for(size_t i=0; i<M; i++){
+			const shared_ptr<Contact>& C(cc.linView[cLinIx(i)]);
+			Particle *pA=C->leakPA(), *pB=C->leakPB();
+			pA->contacts[pB->id]=C;
+			pB->contacts[pA->id]=C;
+		}
+	}
+
+	// contents of the file: mapped read-only when uncompressed (saves copying the file into a buffer), otherwise decompressed into memory
+	struct FileData{
+		boost::iostreams::mapped_file_source mapped;
+		string buf;
+		const char* data; size_t size;
+		FileData(const string& in, bool useMmap): data(NULL), size(0){
+			const bool compressed=boost::algorithm::ends_with(in,".bz2") || boost::algorithm::ends_with(in,".gz") || boost::algorithm::ends_with(in,".bgz");
+			if(useMmap && !compressed){
+				if(!boost::filesystem::exists(in)) throw std::runtime_error("File "+in+" does not exist.");
+				mapped.open(in);
+				if(!mapped.is_open()) throw std::runtime_error("Error mapping file "+in+".");
+				data=mapped.data(); size=mapped.size();
+				#ifdef __linux__
+					// all sections are read, ask for read-ahead of the whole file
+					madvise((void*)data,size,MADV_WILLNEED);
+				#endif
+				return;
+			}
+			boost::iostreams::filtering_istream is;
+			woo::ObjectIO::pushDecompressor(is,in);
+			boost::iostreams::file_source src(in,std::ios_base::in|std::ios_base::binary);
+			if(!src.is_open()) throw std::runtime_error("Error opening file "+in+" for reading.");
+			is.push(src);
+			std::ostringstream oss;
+			boost::iostreams::copy(is,oss);
+			buf=oss.str();
+			data=buf.data(); size=buf.size();
+		}
+	};
+
+	void writeFile(const string& out, const std::function<void(std::ostream&)>& fill){
+		boost::iostreams::filtering_ostream os;
+		woo::ObjectIO::pushCompressor(os,out);
+		// write to a temporary, then rename (as ObjectIO::save)
+		const string tmp=out+".~woo~tmp~";
+		boost::iostreams::file_sink sink(tmp,std::ios_base::out|std::ios_base::binary);
+		if(!sink.is_open()) throw std::runtime_error("Error opening file "+tmp+" for writing.");
+		os.push(sink);
+		fill(os);
+		os.reset(); // flush and close
+		boost::filesystem::rename(tmp,out);
+	}
+}
+
+bool ColumnarCheckpoint::isColumnar(const string& in){
+	boost::iostreams::filtering_istream is;
+	woo::ObjectIO::pushDecompressor(is,in);
+	boost::iostreams::file_source src(in,std::ios_base::in|std::ios_base::binary);
+	if(!src.is_open()) return false;
+	is.push(src);
+	char head[16];
+	is.read(head,sizeof(head));
+	return is.gcount()==sizeof(head) && (memcmp(head,magic,sizeof(head))==0 || memcmp(head,deltaMagic,sizeof(head))==0);
+}
+
+// columns and the boost part, owned by the snapshot
+struct ColumnarCheckpoint::Snapshot{
+	vector<std::unique_ptr<DemColumns>> cols;
+	string boostData;
+	ColumnWriter w;
+	size_t nBytes;
+};
+
+shared_ptr<ColumnarCheckpoint::Snapshot> ColumnarCheckpoint::snapshot(const shared_ptr<Scene>& scene){
+	if(!scene) throw std::invalid_argument("ColumnarCheckpoint.snapshot: scene must not be None.");
+	// particles, nodes and contacts are taken out of DemFields for a while, engines must not run meanwhile
+	if(scene->running() && boost::this_thread::get_id()!=scene->bgThreadId) throw std::runtime_error("ColumnarCheckpoint: the scene is running in the background; stop it first (Scene.stop, Scene.wait), or save from within the simulation (CheckpointSaver, PyRunner).");
+	auto snap=make_shared<Snapshot>();
+	auto cc=make_shared<ColumnarCheckpoint>();
+	cc->scene=scene;
+	std::unordered_map<Material*,int> matIx;
+	{
+		vector<std::unique_ptr<DemStripper>> strip;
+		for(size_t fi=0; fi<scene->fields.size(); fi++){
+			DemField* dem=dynamic_cast<DemField*>(scene->fields[fi].get());
+			if(!dem) continue;
+			snap->cols.emplace_back(new DemColumns);
+			snap->cols.back()->gather(*dem,cc->materials,matIx);
+			snap->cols.back()->addTo(snap->w,"f"+to_string(fi)+".");
+		}
+		// keep the renderer away while DemFields are incomplete
+		vector<std::unique_ptr<boost::mutex::scoped_lock>> locks;
+		size_t ci=0;
+		for(size_t fi=0; fi<scene->fields.size(); fi++){
+			DemField* dem=dynamic_cast<DemField*>(scene->fields[fi].get());
+			if(!dem) continue;
+			locks.emplace_back(new boost::mutex::scoped_lock(dem->nodesMutex));
+			#if defined(WOO_OPENMP) || defined(WOO_OPENGL)
+				locks.emplace_back(new boost::mutex::scoped_lock(dem->contacts->manipMutex));
+			#endif
+			strip.emplace_back(new DemStripper(*dem,*snap->cols[ci++]));
+		}
+		std::ostringstream oss;
+		shared_ptr<Object> obj(cc);
+		woo::ObjectIO::save<shared_ptr<Object>,boost::archive::binary_oarchive>(oss,"woo__Object",obj);
+		snap->boostData=oss.str();
+		// strip is destroyed (DemFields restored) before locks are released
+		strip.clear();
+	}
+	snap->w.add("boost",snap->boostData.data(),1,snap->boostData.size(),/*detectConst*/false);
+	snap->nBytes=snap->w.layout();
+	LOG_DEBUG("Columnar snapshot: "<<snap->w.sections.size()<<" sections, "<<snap->nBytes<<" bytes ("<<snap->boostData.size()<<" bytes of boost::serialization data).");
+	const Stats st=snapshotStats(snap);
+	LOG_INFO("Columnar snapshot: "<<st.parColumnar<<" particles and "<<st.conColumnar<<" contacts in columns; with boost::serialization "<<st.parType<<"+"<<st.parShared<<" particles and "<<st.conType<<"+"<<st.conShared<<" contacts (other type + referenced from elsewhere).");
+	return snap;
+}
+
+ColumnarCheckpoint::Stats ColumnarCheckpoint::snapshotStats(const shared_ptr<Snapshot>& snap){
+	Stats ret={0,0,0,0,0,0};
+	for(const auto& c: snap->cols){
+		ret.parColumnar+=c->parIds.size(); ret.parType+=c->parType; ret.parShared+=c->parShared;
+		ret.conColumnar+=c->conIx.size(); ret.conType+=c->conType; ret.conShared+=c->conShared;
+	}
+	return ret;
+}
+
+py::dict ColumnarCheckpoint::pyStats(const Stats& st){
+	py::dict ret;
+	ret["parColumnar"]=st.parColumnar; ret["parType"]=st.parType; ret["parShared"]=st.parShared;
+	ret["conColumnar"]=st.conColumnar; ret["conType"]=st.conType; ret["conShared"]=st.conShared;
+	return ret;
+}
+
+size_t ColumnarCheckpoint::snapshotSize(const shared_ptr<Snapshot>& snap){ return snap->nBytes; }
+
+void ColumnarCheckpoint::write(const shared_ptr<Snapshot>& snap, const string& out, std::atomic<size_t>* progress){
+	writeFile(out,[&](std::ostream& os){ snap->w.write(os,progress); });
+}
+
+py::dict ColumnarCheckpoint::save(const shared_ptr<Scene>& scene, const string& out){
+	if(!scene) throw std::invalid_argument("ColumnarCheckpoint.save: scene must not be None.");
+	const string out2=scene->expandTags(out);
+	scene->lastSave=out2;
+	auto snap=snapshot(scene);
+	write(snap,out2);
+	return pyStats(snapshotStats(snap));
+}
+
+namespace {
+	typedef ColumnarCheckpoint::DeltaHead DeltaHead;
+
+	uint32_t crc32Buf(const char* data, size_t size){
+		uLong crc=crc32(0,NULL,0);
+		const size_t chunk=1<<30;
+		for(size_t o=0; o<size; o+=chunk) crc=crc32(crc,(const Bytef*)data+o,std::min(chunk,size-o));
+		return crc;
+	}
+
+	// changes of section data against base data; see ColumnarCheckpoint::DeltaHead
+	void diffSection(const char* data, size_t nBytes, const char* base, size_t baseBytes, size_t itemSize, string& out){
+		DeltaHead h; memset(&h,0,sizeof(h));
+		h.nBytes=nBytes; h.common=std::min(nBytes,baseBytes);
+		// units of whole items, about 256 bytes
+		h.unit=std::max((size_t)1,256/std::max(itemSize,(size_t)1))*std::max(itemSize,(size_t)1);
+		const long nUnits=(h.common+h.unit-1)/h.unit;
+		vector<char> changed(nUnits);
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(static) if(nUnits>4096)
+		#endif
+		for(long u=0; u<nUnits; u++){
+			const size_t o=u*h.unit;
+			changed[u]=(memcmp(data+o,base+o,std::min((size_t)h.unit,(size_t)h.common-o))!=0);
+		}
+		vector<uint64_t> idx;
+		for(long u=0; u<nUnits; u++){ if(changed[u]) idx.push_back(u); }
+		h.nChanged=idx.size();
+		out.clear();
+		out.append((const char*)&h,sizeof(h));
+		out.append((const char*)idx.data(),idx.size()*sizeof(uint64_t));
+		for(const uint64_t& u: idx){ const size_t o=u*h.unit; out.append(data+o,std::min((size_t)h.unit,(size_t)h.common-o)); }
+		out.append(data+h.common,nBytes-h.common);
+	}
+
+	// reconstruct section data from base data and the delta
+	void patchSection(const char* delta, size_t deltaBytes, const char* base, size_t baseBytes, string& out, const string& name){
+		if(deltaBytes<sizeof(DeltaHead)) throw std::runtime_error("ColumnarCheckpoint: delta of section "+name+" truncated.");
+		const DeltaHead& h(*(const DeltaHead*)delta);
+		if(h.common>h.nBytes || h.common>baseBytes || h.unit==0) throw std::runtime_error("ColumnarCheckpoint: delta of section "+name+" does not match the base.");
+		const uint64_t* idx=(const uint64_t*)(delta+sizeof(h));
+		size_t pos=sizeof(h)+h.nChanged*sizeof(uint64_t);
+		if(pos>deltaBytes) throw std::runtime_error("ColumnarCheckpoint: delta of section "+name+" truncated.");
+		out.assign(base?base:"",h.common);
+		for(size_t i=0; i<h.nChanged; i++){
+			const size_t o=idx[i]*h.unit;
+			if(o>=h.common) throw std::runtime_error("ColumnarCheckpoint: delta of section "+name+" is corrupt.");
+			const size_t n=std::min((size_t)h.unit,(size_t)h.common-o);
+			if(pos+n>deltaBytes) throw std::runtime_error("ColumnarCheckpoint: delta of section "+name+" truncated.");
+			memcpy(&out[o],delta+pos,n);
+			pos+=n;
+		}
+		if(pos+(h.nBytes-h.common)!=deltaBytes) throw std::runtime_error("ColumnarCheckpoint: delta of section "+name+" has wrong size.");
+		out.append(delta+pos,h.nBytes-h.common);
+	}
+
+	bool isDelta(const FileData& f){ return f.size>=16 && memcmp(f.data,ColumnarCheckpoint::deltaMagic,16)==0; }
+
+	// full checkpoint (as stored in file) from delta and its base
+	void applyDelta(const string& in, const FileData& file, bool mmap, string& full){
+		ColumnReader dr(file.data,file.size,ColumnarCheckpoint::deltaMagic);
+		const Section& bs=dr.sec("delta.base");
+		if(bs.nBytes<sizeof(uint64_t)+sizeof(uint32_t)) throw std::runtime_error("ColumnarCheckpoint: "+in+": invalid delta.base section.");
+		uint64_t baseSize; uint32_t baseCrc;
+		memcpy(&baseSize,dr.data(bs),sizeof(baseSize)); memcpy(&baseCrc,dr.data(bs)+sizeof(baseSize),sizeof(baseCrc));
+		string base(dr.data(bs)+sizeof(baseSize)+sizeof(baseCrc),bs.nBytes-sizeof(baseSize)-sizeof(baseCrc));
+		// relative to the delta, if not found as it is
+		if(!boost::filesystem::exists(base) && boost::filesystem::path(base).is_relative()){
+			boost::filesystem::path p2=boost::filesystem::path(in).parent_path()/boost::filesystem::path(base).filename();
+			if(boost::filesystem::exists(p2)) base=p2.string();
+		}
+		FileData bf(base,mmap);
+		if(bf.size!=baseSize || crc32Buf(bf.data,bf.size)!=baseCrc) throw std::runtime_error("ColumnarCheckpoint: "+in+": base checkpoint "+base+" was modified since the delta was written.");
+		ColumnReader br(bf.data,bf.size);
+		// sections of the full checkpoint, in the order of the delta
+		vector<string> data; vector<Section> secs;
+		const ColumnarCheckpoint::Header& h(*(const ColumnarCheckpoint::Header*)file.data);
+		const Section* ds=(const Section*)(file.data+sizeof(h));
+		for(size_t i=0; i<h.nSections; i++){
+			if(!(ds[i].flags&ColumnarCheckpoint::SEC_DELTA)) continue;
+			const Section* b=br.find(ds[i].name);
+			data.push_back(string());
+			patchSection(dr.data(ds[i]),ds[i].nBytes,b?br.data(*b):NULL,b?b->nBytes:0,data.back(),ds[i].name);
+			secs.push_back(ds[i]);
+		}
+		ColumnWriter w;
+		for(size_t i=0; i<secs.size(); i++){
+			w.add(secs[i].name,data[i].data(),1,data[i].size(),/*detectConst*/false);
+			Section& s(w.sections.back());
+			s.itemSize=secs[i].itemSize; s.count=secs[i].count; s.flags=secs[i].flags&~ColumnarCheckpoint::SEC_DELTA;
+		}
+		std::ostringstream oss;
+		w.write(oss);
+		full=oss.str();
+	}
+
+	shared_ptr<Scene> loadData(const char* data, size_t size, const string& in){
+		ColumnReader r(data,size);
+		const Section& b=r.sec("boost");
+		boost::iostreams::stream<boost::iostreams::array_source> is(r.data(b),b.nBytes);
+		auto obj=make_shared<Object>();
+		woo::ObjectIO::load<shared_ptr<Object>,boost::archive::binary_iarchive>(is,"woo__Object",obj);
+		auto cc=dynamic_pointer_cast<ColumnarCheckpoint>(obj);
+		if(!cc || !cc->scene) throw std::runtime_error("ColumnarCheckpoint: "+in+": no Scene in the boost::serialization section.");
+		const shared_ptr<Scene>& scene(cc->scene);
+		for(size_t fi=0; fi<scene->fields.size(); fi++){
+			DemField* dem=dynamic_cast<DemField*>(scene->fields[fi].get());
+			if(!dem) continue;
+			restoreDem(*dem,r,"f"+to_string(fi)+".",cc->materials);
+		}
+		return scene;
+	}
+}
+
+shared_ptr<Scene> ColumnarCheckpoint::load(const string& in, bool mmap){
+	// columns and the boost section are read directly from the file data, without intermediate copies
+	FileData file(in,mmap);
+	if(!isDelta(file)) return loadData(file.data,file.size,in);
+	string full;
+	applyDelta(in,file,mmap,full);
+	return loadData(full.data(),full.size(),in);
+}
+
+void ColumnarCheckpoint::writeDelta(const shared_ptr<Snapshot>& snap, const string& base, const string& out, std::atomic<size_t>* progress){
+	FileData bf(base,/*mmap*/true);
+	if(isDelta(bf)) throw std::runtime_error("ColumnarCheckpoint: base "+base+" is a delta checkpoint (deltas must be relative to a full checkpoint).");
+	ColumnReader br(bf.data,bf.size);
+	const ColumnWriter& sw(snap->w);
+	const size_t N=sw.sections.size();
+	vector<string> payload(N+1);
+	for(size_t i=0; i<N; i++){
+		const Section& s(sw.sections[i]);
+		const Section* b=br.find(s.name);
+		// different layout of items: store everything
+		if(b && b->itemSize!=s.itemSize) b=NULL;
+		diffSection(sw.data[i],s.nBytes,b?br.data(*b):NULL,b?b->nBytes:0,s.itemSize,payload[i]);
+	}
+	ColumnWriter dw;
+	for(size_t i=0; i<N; i++){
+		const Section& s(sw.sections[i]);
+		dw.add(s.name,payload[i].data(),1,payload[i].size(),/*detectConst*/false);
+		Section& d(dw.sections.back());
+		d.itemSize=s.itemSize; d.count=s.count; d.flags=s.flags|SEC_DELTA;
+	}
+	const uint64_t baseSize=bf.size; const uint32_t baseCrc=crc32Buf(bf.data,bf.size);
+	payload[N].append((const char*)&baseSize,sizeof(baseSize));
+	payload[N].append((const char*)&baseCrc,sizeof(baseCrc));
+	payload[N].append(base);
+	dw.add("delta.base",payload[N].data(),1,payload[N].size(),/*detectConst*/false);
+	LOG_DEBUG("Delta checkpoint "<<out<<": "<<dw.layout()<<" bytes (full: "<<snap->nBytes<<").");
+	writeFile(out,[&](std::ostream& os){ dw.write(os,progress,deltaMagic); });
+}
+
+py::dict ColumnarCheckpoint::saveDelta(const shared_ptr<Scene>& scene, const string& base, const string& out){
+	if(!scene) throw std::invalid_argument("ColumnarCheckpoint.saveDelta: scene must not be None.");
+	const string out2=scene->expandTags(out);
+	scene->lastSave=out2;
+	auto snap=snapshot(scene);
+	writeDelta(snap,base,out2);
+	return pyStats(snapshotStats(snap));
+}
+
+py::list ColumnarCheckpoint::pySections(const string& in){
+	FileData file(in,/*mmap*/true);
+	ColumnReader r(file.data,file.size,isDelta(file)?deltaMagic:magic);
+	const Header& h(*(const Header*)file.data);
+	const Section* ss=(const Section*)(file.data+sizeof(h));
+	py::list ret;
+	for(size_t i=0; i<h.nSections; i++){
+		py::dict d;
+		d["name"]=string(ss[i].name); d["count"]=ss[i].count; d["itemSize"]=ss[i].itemSize; d["nBytes"]=ss[i].nBytes;
+		d["const"]=bool(ss[i].flags&SEC_CONST); d["delta"]=bool(ss[i].flags&SEC_DELTA);
+		ret.append(d);
+	}
+	return ret;
+}
+
+void ColumnarCheckpoint::replay(const string& in, const string& out){
+	FileData file(in,/*mmap*/true);
+	if(!isDelta(file)) throw std::runtime_error("ColumnarCheckpoint.replay: "+in+" is not a delta checkpoint.");
+	string full;
+	applyDelta(in,file,/*mmap*/true,full);
+	writeFile(out,[&](std::ostream& os){ os.write(full.data(),full.size()); });
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include<woo/pkg/dem/Particle.hpp>
+#include<woo/pkg/dem/Contact.hpp>
+#include<woo/core/Scene.hpp>
+#include<atomic>
+
+/*
+Columnar checkpoint of a Scene.
+
+Spherical particles (with their node) and contacts with L6Geom and FrictPhys (or without geometry
+and physics) are written as typed arrays (columns), one row per particle or contact (geometry and
+physics columns have rows for real contacts only, flagged in con.real); everything
+else (the Scene itself, engines, other particles, nodes and contacts) is serialized with
+boost::serialization, into one section of the file. The boost part references materials of
+columnar particles through a table, so that shared materials remain shared.
+
+A particle is written to columns only if nothing else references it, its shape or its node (checked
+via use_count), and if no contact stored with boost references it; all other objects are left to
+boost::serialization, so that object identity is always preserved. How many objects were stored
+either way is logged and returned by save, so that objects falling back to boost::serialization
+(which is much slower) are not missed.
+
+The file starts with a fixed-size header and a table of sections; data of each section are aligned
+to 64 bytes from the beginning of the file. Uncompressed files are memory-mapped when loaded, which
+saves reading the file into a buffer first; objects are still created and filled from the columns,
+so the mapping is only an I/O optimization. Columns where all items are identical are stored as one
+item only (SEC_CONST).
+
+Delta checkpoints have the same layout (with deltaMagic), and are relative to a full checkpoint
+(the base), of which the name, size and CRC are stored in the delta.base section. Every section
+of the full checkpoint is stored as changes of its data against the same section of the base
+(SEC_DELTA): data are compared in units of whole items (about 256 bytes), and only units which
+differ are stored, followed by data beyond the end of the base section (see DeltaHead). This covers
+everything without knowing what the data are: node kinematics, contacts which were added, removed
+or changed, and the boost-serialized part (material states, engines). Loading a delta
+reconstructs the full checkpoint in memory first.
+*/
+struct ColumnarCheckpoint: public Object{
+	WOO_DECL_LOGGER;
+	static const char magic[17], deltaMagic[17];
+	enum{ VERSION=2, ENDIAN=0x01020304, ALIGN=64 };
+	enum{ SEC_CONST=1, SEC_DELTA=2 };
+	struct Header{
+		char magic[16];
+		uint32_t version, endian, realSize, nSections;
+	};
+	struct Section{
+		char name[32];
+		uint32_t itemSize, flags;
+		uint64_t count, offset, nBytes;
+	};
+	// beginning of SEC_DELTA data, followed by nChanged unit indices (uint64_t), data of those units, and data beyond common
+	struct DeltaHead{
+		uint64_t nBytes, common, nChanged; // size of the full section, size compared with the base, number of changed units
+		uint32_t unit, pad; // unit size (multiple of itemSize)
+	};
+	static_assert(sizeof(Header)==32,"ColumnarCheckpoint::Header must be packed.");
+	static_assert(sizeof(Section)==64,"ColumnarCheckpoint::Section must be packed.");
+	static_assert(sizeof(DeltaHead)==32,"ColumnarCheckpoint::DeltaHead must be packed.");
+
+	// save scene to file; .gz, .bgz or .bz2 extension compresses the whole file; returns stats (see Stats)
+	static py::dict save(const shared_ptr<Scene>& scene, const string& out);
+	// in-memory copy of the scene (columns and boost-serialized data), which can be written later, from another thread
+	struct Snapshot;
+	static shared_ptr<Snapshot> snapshot(const shared_ptr<Scene>& scene);
+	// number of particles and contacts stored in columns, and by boost::serialization (because of their type or content, or because they are referenced from elsewhere)
+	struct Stats{ size_t parColumnar, parType, parShared, conColumnar, conType, conShared; };
+	static Stats snapshotStats(const shared_ptr<Snapshot>&);
+	static py::dict pyStats(const Stats&);
+	// size of the file written from the snapshot (without compression)
+	static size_t snapshotSize(const shared_ptr<Snapshot>&);
+	// write snapshot to file; progress (if given) is incremented by the number of bytes written
+	static void write(const shared_ptr<Snapshot>&, const string& out, std::atomic<size_t>* progress=NULL);
+	// write snapshot as delta against full checkpoint base (which must exist)
+	static void writeDelta(const shared_ptr<Snapshot>&, const string& base, const string& out, std::atomic<size_t>* progress=NULL);
+	static py::dict saveDelta(const shared_ptr<Scene>& scene, const string& base, const string& out);
+	// write full checkpoint from delta (and its base)
+	static void replay(const string& in, const string& out);
+	// load scene (full or delta); uncompressed files are memory-mapped unless mmap is false
+	static shared_ptr<Scene> load(const string& in, bool mmap=true);
+	// whether the file (possibly compressed) is a columnar checkpoint (full or delta)
+	static bool isColumnar(const string& in);
+	// table of sections of the file, for inspection
+	static py::list pySections(const string& in);
+
+	#define woo_dem_ColumnarCheckpoint__CLASS_BASE_DOC_ATTRS_PY \
+		ColumnarCheckpoint,Object,"Compact columnar checkpoint of :obj:`woo.core.Scene`: spherical particles (with their nodes) and contacts (with :obj:`L6Geom` and :obj:`FrictPhys`) of :obj:`DemField` are stored as typed arrays (positions, velocities, radii, material index, contact pairs, per-contact state), everything else with boost::serialization. Particle :obj:`bounds <Shape.bound>` are not saved (they are recomputed by the collider) and neither is contact color. Use :obj:`save` and :obj:`load` (or :obj:`woo.core.Object.load`, which detects the format automatically); instances of this class only hold the boost-serialized part of the file.", \
+		((shared_ptr<Scene>,scene,,AttrTrait<Attr::readonly>(),"Scene, without particles, nodes and contacts stored in columns.")) \
+		((vector<shared_ptr<Material>>,materials,,AttrTrait<Attr::readonly>(),"Materials of particles stored in columns, referenced by index.")) \
+		,/*py*/ \
+		.def("save",&ColumnarCheckpoint::save,(py::arg("scene"),py::arg("out")),"Save *scene* to file *out* (``{tags}`` are expanded, and :obj:`Scene.lastSave` is set); the whole file is compressed if the name ends with ``.gz``, ``.bgz`` (block-parallel gzip) or ``.bz2``. The scene must not be running in the background, unless this is called from within the simulation (e.g. from :obj:`woo.core.PyRunner`). Returns a dictionary with the number of particles and contacts stored in columns (``parColumnar``, ``conColumnar``) and with boost::serialization, either because of their type or content (``parType``, ``conType``: other shapes, geometry or physics, clumps, imposed motion, …) or because they are referenced from elsewhere (``parShared``, ``conShared``: by engines, python variables, or by contacts stored with boost::serialization), so that they keep their identity after loading.").staticmethod("save") \
+		.def("saveDelta",&ColumnarCheckpoint::saveDelta,(py::arg("scene"),py::arg("base"),py::arg("out")),"Save *scene* to file *out* as changes against full checkpoint *base* (saved with :obj:`save`); only data which differ from the base are stored. The base must not be modified or removed as long as the delta is used (this is checked when loading); it is looked up next to the delta if not found under the original name. Returns the same dictionary as :obj:`save`.").staticmethod("saveDelta") \
+			.def("replay",&ColumnarCheckpoint::replay,(py::arg("in"),py::arg("out")),"Write full checkpoint *out* from delta checkpoint *in* and its base.").staticmethod("replay") \
+			.def("load",&ColumnarCheckpoint::load,(py::arg("in"),py::arg("mmap")=true),"Load scene saved with :obj:`save` or :obj:`saveDelta`. Uncompressed files are memory-mapped (unless *mmap* is ``False``) and columns are read from the mapping instead of from a copy of the file in memory; all particles, nodes and contacts are still created as usual, hence this only saves one copy of the file data.").staticmethod("load") \
+		.def("isColumnar",&ColumnarCheckpoint::isColumnar,(py::arg("in")),"Tell whether given file is a columnar checkpoint (full or delta).").staticmethod("isColumnar") \
+		.def("sections",&ColumnarCheckpoint::pySections,(py::arg("in")),"Return sections stored in checkpoint *in* (full or delta), as list of dictionaries with keys ``name``, ``count`` (number of items), ``itemSize``, ``nBytes`` (size of data in the file), ``const`` (all items are identical and only one is stored) and ``delta`` (data are stored as changes against the base).").staticmethod("sections")
+	WOO_DECL__CLASS_BASE_DOC_ATTRS_PY(woo_dem_ColumnarCheckpoint__CLASS_BASE_DOC_ATTRS_PY);
+};
+WOO_REGISTER_OBJECT(ColumnarCheckpoint);
@@ -18,6 +18,7 @@ void Contact::swapOrder(){
 void Contact::reset(){
 	geom=shared_ptr<CGeom>();
 	phys=shared_ptr<CPhys>();
+	loopBucketStamp=0;
 	// stepCreated=-1;
 }
 
@@ -7,6 +7,7 @@
 #include<woo/core/Scene.hpp>
 #include<woo/pkg/dem/Particle.hpp> // for Particle::id_t
 #include<woo/lib/pyutil/converters.hpp>
+#include<woo/lib/base/SlabPool.hpp>
 
 
 struct Particle;
@@ -18,7 +19,7 @@ struct CGeom: public Object,public Indexable{
 	// XXX: is createIndex() called here at all??
 	#define woo_dem_CGeom__CLASS_BASE_DOC_ATTRS_CTOR_PY \
 		CGeom,Object,ClassTrait().doc("Geometrical configuration of contact").section("Geometry","TODO",{"CGeomFunctor","CGeomDispatcher"}), \
-		((shared_ptr<Node>,node,make_shared<Node>(),,"Local coordinates definition.")) \
+		((shared_ptr<Node>,node,woo::slab_make_shared<Node>(),,"Local coordinates definition.")) \
 		,/*ctor*/ createIndex(); ,/*py*/WOO_PY_TOPINDEXABLE(CGeom);
 	WOO_DECL__CLASS_BASE_DOC_ATTRS_CTOR_PY(woo_dem_CGeom__CLASS_BASE_DOC_ATTRS_CTOR_PY);
 	REGISTER_INDEX_COUNTER(CGeom);
@@ -84,6 +85,9 @@ struct Contact: public Object{
 	Particle* leakOther(const Particle* p) const { assert(p==leakPA() || p==leakPB()); return (p!=leakPA()?leakPA():leakPB()); }
 	shared_ptr<Particle> pyPA() const { return pA.lock(); }
 	shared_ptr<Particle> pyPB() const { return pB.lock(); }
+	// bucket of functors in ContactLoop (with ContactLoop.bucketing); only valid if loopBucketStamp matches the one of ContactLoop
+	int loopBucket=-1;
+	unsigned loopBucketStamp=0;
 	#ifdef WOO_OPENGL
 		#define woo_dem_Contact__OPENGL__color ((Real,color,0,,"(Normalized) color value for this contact"))
 	#else
@@ -1,6 +1,8 @@
 #include<woo/pkg/dem/ContactContainer.hpp>
 #include<woo/pkg/dem/Particle.hpp>
 #include<woo/pkg/dem/Contact.hpp>
+#include<chrono>
+#include<random>
 
 #ifdef WOO_OPENMP
 	#include<omp.h>
@@ -66,6 +68,102 @@ void ContactContainer::removeMaybe_fast(const shared_ptr<Contact>& c){
 	linView_remove(c->linIx);
 }
 
+void ContactContainer::concurrentLockPair(int idA, int idB){
+	size_t a=idA%nConcurrentStripes, b=idB%nConcurrentStripes;
+	if(a>b) std::swap(a,b);
+	concurrentStripes[a].lock();
+	if(a!=b) concurrentStripes[b].lock();
+}
+
+void ContactContainer::concurrentUnlockPair(int idA, int idB){
+	size_t a=idA%nConcurrentStripes, b=idB%nConcurrentStripes;
+	concurrentStripes[a].unlock();
+	if(a!=b) concurrentStripes[b].unlock();
+}
+
+void ContactContainer::beginConcurrent(size_t maxAdd){
+	if(!concurrentStripes) concurrentStripes.reset(new SpinLock[nConcurrentStripes]);
+	#ifdef WOO_OPENMP
+		concurrentFree.resize(omp_get_max_threads());
+	#else
+		concurrentFree.resize(1);
+	#endif
+	for(auto& f: concurrentFree) f.clear();
+	concurrentSize=linView.size();
+	concurrentOverflow=0;
+	// slots are written by threads directly, the storage must not be reallocated meanwhile
+	linView.resize(linView.size()+maxAdd);
+}
+
+bool ContactContainer::addConcurrent(const shared_ptr<Contact>& c){
+	Particle *pA=c->leakPA(), *pB=c->leakPB();
+	concurrentLockPair(pA->id,pB->id);
+	if(pA->contacts.count(pB->id)==1){ concurrentUnlockPair(pA->id,pB->id); return false; }
+	pA->contacts[pB->id]=c;
+	pB->contacts[pA->id]=c;
+	concurrentUnlockPair(pA->id,pB->id);
+	#ifdef WOO_OPENMP
+		vector<size_t>& freeSlots=concurrentFree[omp_get_thread_num()];
+	#else
+		vector<size_t>& freeSlots=concurrentFree[0];
+	#endif
+	size_t ix;
+	if(!freeSlots.empty()){ ix=freeSlots.back(); freeSlots.pop_back(); }
+	else{
+		ix=concurrentSize.fetch_add(1);
+		// can't throw from inside a parallel section; undo and report in endConcurrent
+		if(ix>=linView.size()){
+			concurrentLockPair(pA->id,pB->id);
+			pA->contacts.erase(pA->contacts.find(pB->id));
+			pB->contacts.erase(pB->contacts.find(pA->id));
+			concurrentUnlockPair(pA->id,pB->id);
+			concurrentOverflow++;
+			return false;
+		}
+	}
+	linView[ix]=c;
+	c->linIx=ix;
+	return true;
+}
+
+bool ContactContainer::removeConcurrent(const shared_ptr<Contact>& c){
+	Particle *pA=c->leakPA(), *pB=c->leakPB();
+	concurrentLockPair(pA->id,pB->id);
+	const auto iA=pA->contacts.find(pB->id);
+	if(iA==pA->contacts.end()){ concurrentUnlockPair(pA->id,pB->id); return false; }
+	pA->contacts.erase(iA);
+	pB->contacts.erase(pB->contacts.find(pA->id));
+	concurrentUnlockPair(pA->id,pB->id);
+	// only this thread could have removed the contact from particles, so it owns the slot now
+	size_t ix=c->linIx;
+	linView[ix].reset();
+	#ifdef WOO_OPENMP
+		concurrentFree[omp_get_thread_num()].push_back(ix);
+	#else
+		concurrentFree[0].push_back(ix);
+	#endif
+	return true;
+}
+
+void ContactContainer::endConcurrent(){
+	// concurrentSize is past the end if some additions overflowed
+	size_t n=std::min((size_t)concurrentSize,linView.size());
+	linView.resize(n);
+	vector<size_t> holes;
+	for(auto& f: concurrentFree){ holes.insert(holes.end(),f.begin(),f.end()); f.clear(); }
+	std::sort(holes.begin(),holes.end());
+	// fill holes from the lowest with contacts from the end
+	for(size_t h=0; h<holes.size(); h++){
+		while(n>0 && !linView[n-1]) n--;
+		if(holes[h]>=n) break;
+		linView[holes[h]]=std::move(linView[n-1]);
+		linView[holes[h]]->linIx=holes[h];
+		n--;
+	}
+	linView.resize(n);
+	if(concurrentOverflow>0) throw std::logic_error("ContactContainer::addConcurrent: "+to_string((size_t)concurrentOverflow)+" contacts more than reserved in beginConcurrent were not added.");
+}
+
 void ContactContainer::linView_remove(const size_t& ix){
 	if(ix<linView.size()-1){ // is not the last element
 		//cerr<<"linIx="<<ix<<"/"<<linView.size()<<endl;
@@ -229,3 +327,55 @@ shared_ptr<Contact> ContactContainer::pyIterator::next(){
 }
 ContactContainer::pyIterator ContactContainer::pyIterator::iter(){ return *this; }
 
+
+
+namespace {
+	// time insertion, lookup (hits and misses) and removal on nPar maps with k keys each; return ns per operation
+	template<typename MapT>
+	std::vector<Real> benchParticleIndex_one(const vector<vector<int>>& keys, const vector<vector<int>>& misses, int nRep){
+		typedef std::chrono::high_resolution_clock clock;
+		auto ns=[](const clock::time_point& t0, const clock::time_point& t1){ return (Real)std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count(); };
+		vector<MapT> mm(keys.size());
+		shared_ptr<Contact> c=make_shared<Contact>();
+		Real tIns=0, tHit=0, tMiss=0, tErase=0; size_t nOps=0, found=0;
+		for(int rep=0; rep<nRep; rep++){
+			auto t0=clock::now();
+			for(size_t i=0; i<keys.size(); i++) for(int k: keys[i]) mm[i][k]=c;
+			auto t1=clock::now();
+			for(size_t i=0; i<keys.size(); i++) for(int k: keys[i]) found+=(mm[i].find(k)!=mm[i].end());
+			auto t2=clock::now();
+			for(size_t i=0; i<keys.size(); i++) for(int k: misses[i]) found+=(mm[i].find(k)!=mm[i].end());
+			auto t3=clock::now();
+			for(size_t i=0; i<keys.size(); i++) for(int k: keys[i]) mm[i].erase(mm[i].find(k));
+			auto t4=clock::now();
+			tIns+=ns(t0,t1); tHit+=ns(t1,t2); tMiss+=ns(t2,t3); tErase+=ns(t3,t4);
+			nOps+=keys.size()*keys[0].size();
+		}
+		if(found!=nOps) throw std::logic_error("ContactContainer.benchParticleIndex: lookup mismatch ("+to_string(found)+" found, "+to_string(nOps)+" expected).");
+		return {tIns/nOps,tHit/nOps,tMiss/nOps,tErase/nOps};
+	}
+}
+
+py::list ContactContainer::pyBenchParticleIndex(const vector<int>& coordNums, int nPar, int nRep){
+	if(nPar<=0 || nRep<=0) throw std::invalid_argument("ContactContainer.benchParticleIndex: nPar and nRep must be positive.");
+	std::mt19937 gen(0);
+	std::uniform_int_distribution<int> dist(0,100*nPar);
+	py::list ret;
+	for(int k: coordNums){
+		if(k<=0) throw std::invalid_argument("ContactContainer.benchParticleIndex: coordination numbers must be positive.");
+		vector<vector<int>> keys(nPar), misses(nPar);
+		for(int i=0; i<nPar; i++){
+			std::set<int> kk; while((int)kk.size()<2*k) kk.insert(dist(gen));
+			vector<int> all(kk.begin(),kk.end()); std::shuffle(all.begin(),all.end(),gen);
+			keys[i].assign(all.begin(),all.begin()+k); misses[i].assign(all.begin()+k,all.end());
+		}
+		auto idx=benchParticleIndex_one<Particle::MapParticleContact>(keys,misses,nRep);
+		auto map=benchParticleIndex_one<std::map<int,shared_ptr<Contact>>>(keys,misses,nRep);
+		py::dict d;
+		d["coordNum"]=k;
+		d["insert"]=idx[0]; d["find"]=idx[1]; d["findMiss"]=idx[2]; d["erase"]=idx[3];
+		d["mapInsert"]=map[0]; d["mapFind"]=map[1]; d["mapFindMiss"]=map[2]; d["mapErase"]=map[3];
+		ret.append(d);
+	}
+	return ret;
+}
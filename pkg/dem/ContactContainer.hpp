@@ -2,6 +2,8 @@
 #include<woo/pkg/dem/ParticleContainer.hpp>
 
 #include<boost/iterator/filter_iterator.hpp>
+#include<atomic>
+#include<memory>
 
 
 #ifdef WOO_OPENMP
@@ -30,6 +32,34 @@ struct ContactContainer: public Object{
 		void removeMaybe_fast(const shared_ptr<Contact>& c);
 		void linView_remove(const size_t& ix);
 
+	/* concurrent mode: contacts are added/removed from several threads at once */
+		/*
+		Between beginConcurrent and endConcurrent, addConcurrent and removeConcurrent may be called from any OpenMP thread, without holding manipMutex; no other method may be called meanwhile (the caller holds manipMutex for the whole section, to keep the renderer away).
+
+		* particles' contact indices are guarded by striped spinlocks (two stripes per contact, always taken in the same order);
+		* linView slots are reserved with an atomic counter, and slots freed by removals are reused from per-thread free lists; contacts beyond maxAdd are not added, and endConcurrent throws then (not addConcurrent, which runs inside parallel sections);
+		* endConcurrent moves trailing contacts into slots left empty and fixes linIx, so linView is dense again.
+
+		The order of contacts in linView depends on thread scheduling.
+		*/
+		void beginConcurrent(size_t maxAdd);
+		bool addConcurrent(const shared_ptr<Contact>& c);
+		bool removeConcurrent(const shared_ptr<Contact>& c);
+		void endConcurrent();
+		struct SpinLock{
+			std::atomic<bool> flag;
+			SpinLock(): flag(false){}
+			void lock(){ while(flag.exchange(true,std::memory_order_acquire)){ while(flag.load(std::memory_order_relaxed)); } }
+			void unlock(){ flag.store(false,std::memory_order_release); }
+		};
+		enum{ nConcurrentStripes=4096 };
+		std::unique_ptr<SpinLock[]> concurrentStripes;
+		std::atomic<size_t> concurrentSize;
+		std::atomic<size_t> concurrentOverflow; // additions beyond maxAdd, reported by endConcurrent
+		vector<vector<size_t>> concurrentFree; // per-thread lists of linView slots emptied by removeConcurrent
+		void concurrentLockPair(int idA, int idB);
+		void concurrentUnlockPair(int idA, int idB);
+
 
 		bool add(const shared_ptr<Contact>& c, bool threadSafe=false);
 		// copy of shared_ptr, so that the argument does not get deleted while being manipulated with
@@ -103,9 +133,10 @@ struct ContactContainer: public Object{
 		shared_ptr<Contact> pyByIds(const Vector2i& ids); // ParticleContainer::id_t id1, ParticleContainer::id_t id2);
 		shared_ptr<Contact> pyNth(int n);
 		pyIterator pyIter();
+		static py::list pyBenchParticleIndex(const vector<int>& coordNums, int nPar, int nRep);
 
 	#ifdef WOO_OPENMP
-		#define woo_dem_ContactContainer__threadsPending__OPENMP ((std::vector<std::vector<PendingContact>>,threadsPending,std::vector<std::vector<PendingContact>>(omp_get_max_threads()),AttrTrait<Attr::hidden>(),"Contacts which might be deleted by the collider in the next step (separate for each thread, for safe lock-free writes)"))
+		#define woo_dem_ContactContainer__threadsPending__OPENMP ((std::vector<std::vector<PendingContact>>,threadsPending,std::vector<std::vector<PendingContact>>(omp_get_max_threads()),AttrTrait<Attr::hidden>(),"Contacts which might be deleted by the collider in the next step (separate for each thread, so that threads write without locking)"))
 	#else
 		#define woo_dem_ContactContainer__threadsPending__OPENMP ((std::vector<PendingContact>,pending,,AttrTrait<Attr::hidden>(),"Contact which might be deleted by the collider in the next step."))
 	#endif
@@ -129,6 +160,7 @@ struct ContactContainer: public Object{
 		.def("existsReal",&ContactContainer::existsReal) \
 		/* .def("__contains__",&ContactContainer::pyContains,"Equivalent to :obj:`existsReal`, but taking tuple as argument.") */ \
 		.def("__iter__",&ContactContainer::pyIter) \
+		.def("benchParticleIndex",&ContactContainer::pyBenchParticleIndex,(py::arg("coordNums")=vector<int>({4,6,8,12,16,20}),py::arg("nPar")=10000,py::arg("nRep")=10),"Benchmark per-particle contact index (:obj:`Particle.allContacts`) against ``std::map``: for each coordination number, *nPar* indices are filled with random ids, then looked up (existing and non-existing ids) and emptied, *nRep* times. Returns list of dicts with times per operation in nanoseconds.").staticmethod("benchParticleIndex") \
 		/* define nested iterator class here; ugly, same as in ParticleContainer */ \
 		; py::scope foo(_classObj); \
 		py::class_<ContactContainer::pyIterator>("ContactContainer_iterator",py::init<pyIterator>()).def("__iter__",&pyIterator::iter).def(WOO_next_OR__next__,&pyIterator::next);
@@ -3,6 +3,14 @@
 
 // temporary
 #include<woo/pkg/dem/G3Geom.hpp>
+// functors with specialized bucket kernels
+#include<woo/pkg/dem/Sphere.hpp>
+#include<woo/pkg/dem/IdealElPl.hpp>
+#include<woo/pkg/dem/Leapfrog.hpp>
+
+#include<atomic>
+#include<typeinfo>
+#include<type_traits>
 
 WOO_PLUGIN(dem,(CGeomFunctor)(CGeomDispatcher)(CPhysFunctor)(CPhysDispatcher)(LawFunctor)(LawDispatcher)(ContactLoop));
 WOO_IMPL_LOGGER(ContactLoop);
@@ -10,7 +18,7 @@ WOO_IMPL_LOGGER(ContactLoop);
 WOO_IMPL__CLASS_BASE_DOC_PY(woo_dem_CGeomFunctor__CLASS_BASE_DOC_PY);
 WOO_IMPL__CLASS_BASE_DOC_PY(woo_dem_CPhysFunctor__CLASS_BASE_DOC_PY);
 WOO_IMPL__CLASS_BASE_DOC_PY(woo_dem_LawFunctor__CLASS_BASE_DOC_PY);
-WOO_IMPL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_ContactLoop__CLASS_BASE_DOC_ATTRS_CTOR);
+WOO_IMPL__CLASS_BASE_DOC_ATTRS_CTOR_PY(woo_dem_ContactLoop__CLASS_BASE_DOC_ATTRS_CTOR_PY);
 
 
 shared_ptr<Contact> CGeomDispatcher::explicitAction(Scene* _scene, const shared_ptr<Particle>& p1, const shared_ptr<Particle>& p2, bool force){
@@ -90,53 +98,108 @@ void ContactLoop::reorderContacts(){
 	}
 }
 
-void ContactLoop::run(){
-	#ifdef CONTACTLOOP_TIMING
-		timingDeltas->start();
-	#endif
+void ContactLoop::bucketsInvalidate(){
+	// stamps are unique across all ContactLoop instances, so that contacts never match buckets of another loop
+	static std::atomic<unsigned> lastStamp(0);
+	bucketStamp=++lastStamp;
+	if(bucketStamp==0) bucketStamp=++lastStamp; // wrapped around, 0 is reserved for "no bucket"
+	buckets.clear();
+	bucketFunctors=dispatcherFunctors();
+}
 
-	DemField& dem=field->cast<DemField>();
+vector<Functor*> ContactLoop::dispatcherFunctors() const {
+	vector<Functor*> ret;
+	for(const auto& f: geoDisp->functors) ret.push_back(f.get());
+	for(const auto& f: phyDisp->functors) ret.push_back(f.get());
+	for(const auto& f: lawDisp->functors) ret.push_back(f.get());
+	return ret;
+}
 
-	if(dem.contacts->removeAllPending()>0 && !alreadyWarnedNoCollider){
-		LOG_WARN("Contacts pending removal found (and were removed); no collider being used?");
-		alreadyWarnedNoCollider=true;
+int ContactLoop::contactBucket(const shared_ptr<Contact>& C){
+	assert(C->isReal());
+	int ret=-1;
+	#ifdef WOO_OPENMP
+		#pragma omp critical(contactLoopBuckets)
+	#endif
+	{
+		if(C->loopBucketStamp==bucketStamp) ret=C->loopBucket; // resolved by another thread meanwhile
+		else {
+			Particle *pA=C->leakPA(), *pB=C->leakPB();
+			bool swapG, swapP, swapL;
+			CGeomFunctor* cg=geoDisp->getFunctor2D(pA->shape,pB->shape,swapG).get();
+			CPhysFunctor* cp=phyDisp->getFunctor2D(pA->material,pB->material,swapP).get();
+			LawFunctor* law=lawDisp->getFunctor2D(C->geom,C->phys,swapL).get();
+			// contacts needing swapped arguments are left to the dispatchers
+			if(cg && cp && law && !swapG && !swapP && !swapL){
+				for(size_t i=0; i<buckets.size(); i++){
+					if(buckets[i].cg==cg && buckets[i].cp==cp && buckets[i].law==law){ ret=(int)i; break; }
+				}
+				if(ret<0){
+					ContactBucket b; b.cg=cg; b.cp=cp; b.law=law;
+					// exact type match, since derived classes may override go
+					if(typeid(*cg)==typeid(Cg2_Sphere_Sphere_L6Geom) && typeid(*law)==typeid(Law2_L6Geom_FrictPhys_IdealElPl)) b.kernel=&ContactLoop::runBucket<Cg2_Sphere_Sphere_L6Geom,Law2_L6Geom_FrictPhys_IdealElPl>;
+					else b.kernel=&ContactLoop::runBucket<CGeomFunctor,LawFunctor>;
+					ret=(int)buckets.size();
+					buckets.push_back(b);
+				}
+			}
+			C->loopBucket=ret;
+			C->loopBucketStamp=bucketStamp;
+		}
 	}
+	return ret;
+}
 
-	if(dem.contacts->dirty){
-		throw std::logic_error("ContactContainer::dirty is true; the collider should re-initialize in such case and clear the dirty flag.");
+py::list ContactLoop::pyBuckets() const {
+	py::list ret;
+	for(const ContactBucket& b: buckets){
+		py::dict d;
+		d["cg"]=b.cg->getClassName(); d["cp"]=b.cp->getClassName(); d["law"]=b.law->getClassName();
+		d["num"]=b.ix.size();
+		d["specialized"]=(b.kernel!=&ContactLoop::runBucket<CGeomFunctor,LawFunctor>);
+		ret.append(d);
 	}
-	// update Scene* of the dispatchers
-	geoDisp->scene=phyDisp->scene=lawDisp->scene=scene;
-	geoDisp->field=phyDisp->field=lawDisp->field=field;
-	// ask dispatchers to update Scene* of their functors
-	geoDisp->updateScenePtr(); phyDisp->updateScenePtr(); lawDisp->updateScenePtr();
-
-	// cache transformed cell size
-	Matrix3r cellHsize; if(scene->isPeriodic) cellHsize=scene->cell->hSize;
-
-	stress=Matrix3r::Zero();
-
-	// force removal of interactions that were not encountered by the collider
-	// (only for some kinds of colliders; see comment for InteractionContainer::iterColliderLastRun)
-	bool removeUnseen=(dem.contacts->stepColliderLastRun>=0 && dem.contacts->stepColliderLastRun==scene->step);
-
-	const bool doStress=(evalStress && scene->isPeriodic);
-	const bool deterministic(scene->deterministic);
-
-	if(reorderEvery>0 && (scene->step%reorderEvery==0)) reorderContacts();
-
-	size_t size=dem.contacts->size();
+	return ret;
+}
 
-	CONTACTLOOP_CHECKPOINT("prologue");
+template<class CgT, class LawT>
+void ContactLoop::runBucket(const ContactBucket& b, const StepFlags& sf){
+	DemField& dem=field->cast<DemField>();
+	// with base classes, call virtually; otherwise, call the final implementation directly
+	const bool cgVirtual=std::is_same<CgT,CGeomFunctor>::value, lawVirtual=std::is_same<LawT,LawFunctor>::value;
+	CgT* cg=static_cast<CgT*>(b.cg); LawT* law=static_cast<LawT*>(b.law);
+	const bool force=false;
+	const size_t n=b.ix.size();
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(guided)
+	#endif
+	for(size_t j=0; j<n; j++){
+		const shared_ptr<Contact>& C=(*dem.contacts)[b.ix[j]];
+		Particle *pA=C->leakPA(), *pB=C->leakPB();
+		Vector3r shift2=(scene->isPeriodic?scene->cell->intrShiftPos(C->cellDist):Vector3r::Zero());
+		bool geomCreated=(cgVirtual?cg->go(pA->shape,pB->shape,shift2,force,C):cg->CgT::go(pA->shape,pB->shape,shift2,force,C));
+		if(!geomCreated){
+			LOG_ERROR("CGeomFunctor "<<b.cg->getClassName()<<" did not update existing contact ##"<<pA->id<<"+"<<pB->id);
+			continue;
+		}
+		if(sf.physNow) b.cp->go(pA->material,pB->material,C);
+		bool keepContact=(lawVirtual?law->go(C->geom,C->phys,C):law->LawT::go(C->geom,C->phys,C));
+		if(!keepContact) dem.contacts->requestRemoval(C);
+		contactForcesStress(C,pA,pB,sf);
+	}
+}
 
+void ContactLoop::runDispatched(const vector<size_t>* ixs, const StepFlags& sf){
+	DemField& dem=field->cast<DemField>();
+	const size_t size=(ixs?ixs->size():dem.contacts->size());
 	#ifdef WOO_OPENMP
 		#pragma omp parallel for schedule(guided)
 	#endif
-	for(size_t i=0; i<size; i++){
+	for(size_t j=0; j<size; j++){
 		CONTACTLOOP_CHECKPOINT("loop-begin");
-		const shared_ptr<Contact>& C=(*dem.contacts)[i];
+		const shared_ptr<Contact>& C=(*dem.contacts)[ixs?(*ixs)[j]:j];
 
-		if(unlikely(removeUnseen && !C->isReal() && C->stepLastSeen<scene->step)) { removeAfterLoop(C); continue; }
+		if(unlikely(sf.removeUnseen && !C->isReal() && C->stepLastSeen<scene->step)) { removeAfterLoop(C); continue; }
 		if(unlikely(!C->isReal() && !C->isColliding())){ removeAfterLoop(C); continue; }
 
 		/* this block is called exactly once for every potential contact created; it should check whether shapes
@@ -175,7 +238,7 @@ void ContactLoop::run(){
 
 		// CPhys
 		if(!C->phys) C->stepCreated=scene->step;
-		if(!C->phys || updatePhys>UPDATE_PHYS_NEVER) phyDisp->operator()(pA->material,pB->material,C);
+		if(!C->phys || sf.physNow) phyDisp->operator()(pA->material,pB->material,C);
 		if(!C->phys) throw std::runtime_error("ContactLoop: ##"+to_string(pA->id)+"+"+to_string(pB->id)+": con Contact.phys created from materials "+pA->material->getClassName()+" and "+pB->material->getClassName()+" (a CPhysFunctor must be available for every contacting material combination).");
 
 		CONTACTLOOP_CHECKPOINT("phys");
@@ -185,42 +248,101 @@ void ContactLoop::run(){
 		if(!keepContact) dem.contacts->requestRemoval(C);
 		CONTACTLOOP_CHECKPOINT("law");
 
-		if(applyForces && C->isReal() && likely(!deterministic)){
-			applyForceUninodal(C,pA);
-			applyForceUninodal(C,pB);
-			#if  0
-			for(const Particle* particle:{pA,pB}){
-				// remove once tested thoroughly
-					const shared_ptr<Shape>& sh(particle->shape);
-					if(!sh || sh->nodes.size()!=1) continue;
-					// if(sh->nodes.size()!=1) continue;
-					#if 0
-						for(size_t i=0; i<sh->nodes.size(); i++){
-							if((sh->nodes[i]->getData<DemData>().flags&DemData::DOF_ALL)!=DemData::DOF_ALL) LOG_WARN("Multinodal #"<<particle->id<<" has free DOFs, but force will not be applied; set ContactLoop.applyForces=False and use IntraForce(...) dispatcher instead.");
-						}
-					#endif
-					Vector3r F,T,xc;
-					std::tie(F,T,xc)=C->getForceTorqueBranch(particle,/*nodeI*/0,scene);
-					sh->nodes[0]->getData<DemData>().addForceTorque(F,xc.cross(F)+T);
-			}
-			#endif
-		}
+		contactForcesStress(C,pA,pB,sf);
+		CONTACTLOOP_CHECKPOINT("force+stress");
+	}
+}
 
-		// track gradV work
-		/* this is meant to avoid calling extra loop at every step, since the work must be evaluated incrementally */
-		if(doStress && /*contact law deleted the contact?*/ C->isReal()){
-			const auto& nnA(pA->shape->nodes); const auto& nnB(pB->shape->nodes);
-			if(nnA.size()!=1 || nnB.size()!=1) throw std::runtime_error("ContactLoop.trackWork not allowed with multi-nodal particles in contact (##"+lexical_cast<string>(pA->id)+"+"+lexical_cast<string>(pB->id)+")");
-			Vector3r branch=C->dPos(scene); // (nnB[0]->pos-nnA[0]->pos+scene->cell->intrShiftPos(C->cellDist));
-			Vector3r F=C->geom->node->ori*C->phys->force; // force in global coords
-			#ifdef WOO_OPENMP
-				#pragma omp critical
-			#endif
-			{
-				stress.noalias()+=F*branch.transpose();
-			}
+void ContactLoop::contactForcesStress(const shared_ptr<Contact>& C, Particle* pA, Particle* pB, const StepFlags& sf){
+	if(applyForces && C->isReal() && likely(!sf.deterministic)){
+		applyForceUninodal(C,pA,sf.threadForces);
+		applyForceUninodal(C,pB,sf.threadForces);
+	}
+
+	// track gradV work
+	/* this is meant to avoid calling extra loop at every step, since the work must be evaluated incrementally */
+	/* partial sums are per-thread, without locking; in the deterministic mode, stress is summed in a fixed order after the loop */
+	if(sf.doStress && /*contact law deleted the contact?*/ C->isReal() && !sf.deterministic) stressAccu+=contactStress(C,pA,pB);
+}
+
+Matrix3r ContactLoop::contactStress(const shared_ptr<Contact>& C, const Particle* pA, const Particle* pB) const {
+	const auto& nnA(pA->shape->nodes); const auto& nnB(pB->shape->nodes);
+	if(nnA.size()!=1 || nnB.size()!=1) throw std::runtime_error("ContactLoop.trackWork not allowed with multi-nodal particles in contact (##"+lexical_cast<string>(pA->id)+"+"+lexical_cast<string>(pB->id)+")");
+	Vector3r branch=C->dPos(scene); // (nnB[0]->pos-nnA[0]->pos+scene->cell->intrShiftPos(C->cellDist));
+	Vector3r F=C->geom->node->ori*C->phys->force; // force in global coords
+	return F*branch.transpose();
+}
+
+void ContactLoop::run(){
+	#ifdef CONTACTLOOP_TIMING
+		timingDeltas->start();
+	#endif
+
+	DemField& dem=field->cast<DemField>();
+
+	if(dem.contacts->removeAllPending()>0 && !alreadyWarnedNoCollider){
+		LOG_WARN("Contacts pending removal found (and were removed); no collider being used?");
+		alreadyWarnedNoCollider=true;
+	}
+
+	if(dem.contacts->dirty){
+		throw std::logic_error("ContactContainer::dirty is true; the collider should re-initialize in such case and clear the dirty flag.");
+	}
+	// update Scene* of the dispatchers
+	geoDisp->scene=phyDisp->scene=lawDisp->scene=scene;
+	geoDisp->field=phyDisp->field=lawDisp->field=field;
+	// ask dispatchers to update Scene* of their functors
+	geoDisp->updateScenePtr(); phyDisp->updateScenePtr(); lawDisp->updateScenePtr();
+
+	stress=Matrix3r::Zero();
+	stressAccu.reset();
+
+	StepFlags sf;
+	// force removal of interactions that were not encountered by the collider
+	// (only for some kinds of colliders; see comment for InteractionContainer::iterColliderLastRun)
+	sf.removeUnseen=(dem.contacts->stepColliderLastRun>=0 && dem.contacts->stepColliderLastRun==scene->step);
+	sf.doStress=(evalStress && scene->isPeriodic);
+	sf.deterministic=scene->deterministic;
+	sf.physNow=(updatePhys>UPDATE_PHYS_NEVER);
+	sf.threadForces=(threadForces && applyForces && !sf.deterministic);
+	if(sf.threadForces){
+		dem.threadForcesReduce(); // leftovers, if something used the buffers without reducing them
+		dem.threadForce.resize(dem.nodes.size()); dem.threadTorque.resize(dem.nodes.size());
+		dem.threadForcesPending=true;
+	}
+
+	if(reorderEvery>0 && (scene->step%reorderEvery==0)) reorderContacts();
+
+	CONTACTLOOP_CHECKPOINT("prologue");
+
+	if(!bucketing) runDispatched(/*all contacts*/NULL,sf);
+	else {
+		// cached buckets are valid until dispatcher functors change; updatePhys='once' means that materials were changed (maybe to another type)
+		// with updatePhys='always', buckets are kept, otherwise all contacts would be resolved again at every step
+		if(bucketStamp==0 || updatePhys==UPDATE_PHYS_ONCE || dispatcherFunctors()!=bucketFunctors) bucketsInvalidate();
+
+		// assign contacts to buckets (-1 for the dispatched ones); resolution of new contacts is serialized inside contactBucket
+		size_t size=dem.contacts->size();
+		bucketOf.resize(size);
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(size_t i=0; i<size; i++){
+			const shared_ptr<Contact>& C=(*dem.contacts)[i];
+			if(!C->isReal()){ bucketOf[i]=-1; continue; }
+			bucketOf[i]=(C->loopBucketStamp==bucketStamp?C->loopBucket:contactBucket(C));
 		}
-		CONTACTLOOP_CHECKPOINT("force+stress");
+		for(ContactBucket& b: buckets) b.ix.clear();
+		dispatchedIx.clear();
+		for(size_t i=0; i<size; i++){
+			if(bucketOf[i]<0) dispatchedIx.push_back(i);
+			else buckets[bucketOf[i]].ix.push_back(i);
+		}
+		CONTACTLOOP_CHECKPOINT("bucketing");
+		for(const ContactBucket& b: buckets){
+			if(!b.ix.empty()) (this->*b.kernel)(b,sf);
+		}
+		runDispatched(&dispatchedIx,sf);
 	}
 	// process removeAfterLoop
 	#ifdef WOO_OPENMP
@@ -233,7 +355,12 @@ void ContactLoop::run(){
 		removeAfterLoopRefs.clear();
 	#endif
 	// compute gradVWork eventually
-	if(doStress){
+	if(sf.doStress){
+		if(!sf.deterministic) stress=stressAccu.get();
+		else {
+			stress=Matrix3r::Zero();
+			for(const auto& C: *dem.contacts){ if(C->isReal()) stress+=contactStress(C,C->leakPA(),C->leakPB()); }
+		}
 		stress/=scene->cell->getVolume();
 		if(scene->trackEnergy){
 			Matrix3r midStress=.5*(stress+prevStress);
@@ -246,24 +373,97 @@ void ContactLoop::run(){
 		prevStress=stress;
 	}
 	// apply forces deterministically, after the parallel loop
-	// this could be also loop over particles in parallel (since per-particle loop would still be deterministic) but time per particle is very small here
-	if(unlikely(deterministic) && applyForces){
-		// non-paralell loop here
-		for(const auto& C: *dem.contacts){
-			if(!C->isReal()) continue;
-			applyForceUninodal(C,C->leakPA());
-			applyForceUninodal(C,C->leakPB());
-		}
+	if(unlikely(sf.deterministic) && applyForces) applyForcesDeterministic();
+	// per-thread forces are reduced by Leapfrog; if there is none, do it here
+	if(sf.threadForces){
+		bool leapfrog=false;
+		for(const auto& e: scene->engines){ if(!e->dead && e->isA<Leapfrog>()){ leapfrog=true; break; } }
+		if(!leapfrog) dem.threadForcesReduce();
 	}
 	// reset updatePhys if it was to be used only once
 	if(updatePhys==UPDATE_PHYS_ONCE) updatePhys=UPDATE_PHYS_NEVER;
 	CONTACTLOOP_CHECKPOINT("epilogue");
 }
 
-void ContactLoop::applyForceUninodal(const shared_ptr<Contact>& C, const Particle* particle){
+/*
+Forces are summed per particle over its real contacts ordered by id of the other particle, which does not depend
+on the number of threads nor on the order of contacts in ContactContainer:
+
+1. F and T (with respect to the node) are computed for both particles of each contact, in parallel over contacts;
+2. they are summed for each particle, in parallel over particles, using Particle::contacts as adjacency;
+3. sums are added to nodes serially, in the order of particle ids (nodes may be shared between particles).
+*/
+void ContactLoop::applyForcesDeterministic(){
+	DemField& dem=field->cast<DemField>();
+	const ContactContainer& cc=*dem.contacts;
+	const ParticleContainer& pc=*dem.particles;
+	const size_t nc=cc.size(), np=pc.size();
+	detContactFT.resize(4*nc);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(size_t i=0; i<nc; i++){
+		const shared_ptr<Contact>& C=cc[i];
+		if(!C->isReal()) continue;
+		for(int k: {0,1}){
+			const Particle* p=(k==0?C->leakPA():C->leakPB());
+			if(!p->shape || p->shape->nodes.size()!=1) continue;
+			Vector3r F,T,xc;
+			std::tie(F,T,xc)=C->getForceTorqueBranch(p,/*nodeI*/0,scene);
+			detContactFT[4*i+2*k]=F;
+			detContactFT[4*i+2*k+1]=xc.cross(F)+T;
+		}
+	}
+	detParticleFT.resize(2*np);
+	detParticleHas.assign(np,0);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel
+	#endif
+	{
+		vector<pair<Particle::id_t,const Contact*>> sorted;
+		#ifdef WOO_OPENMP
+			#pragma omp for schedule(guided)
+		#endif
+		for(size_t id=0; id<np; id++){
+			const shared_ptr<Particle>& p=pc[id];
+			if(!p || !p->shape || p->shape->nodes.size()!=1 || p->contacts.empty()) continue;
+			// the small (non-hashed) index is already sorted by id
+			sorted.clear();
+			for(const auto& I: p->contacts) sorted.push_back(std::make_pair(I.first,I.second.get()));
+			if(p->contacts.isHashed()) std::sort(sorted.begin(),sorted.end());
+			Vector3r F=Vector3r::Zero(), T=Vector3r::Zero();
+			bool has=false;
+			for(const auto& oc: sorted){
+				const Contact* C=oc.second;
+				if(!C->isReal()) continue;
+				int k=(C->leakPA()==p.get()?0:1);
+				F+=detContactFT[4*C->linIx+2*k]; T+=detContactFT[4*C->linIx+2*k+1];
+				has=true;
+			}
+			detParticleFT[2*id]=F; detParticleFT[2*id+1]=T;
+			detParticleHas[id]=has;
+		}
+	}
+	for(size_t id=0; id<np; id++){
+		if(!detParticleHas[id]) continue;
+		pc[id]->shape->nodes[0]->getData<DemData>().addForceTorque(detParticleFT[2*id],detParticleFT[2*id+1]);
+	}
+}
+
+void ContactLoop::applyForceUninodal(const shared_ptr<Contact>& C, const Particle* particle, bool threadForces){
 	const auto& sh(particle->shape);
 	if(!sh || sh->nodes.size()!=1) return;
 	Vector3r F,T,xc;
 	std::tie(F,T,xc)=C->getForceTorqueBranch(particle,/*nodeI*/0,scene);
-	sh->nodes[0]->getData<DemData>().addForceTorque(F,xc.cross(F)+T);
+	const shared_ptr<Node>& node(sh->nodes[0]);
+	DemData& dyn(node->getData<DemData>());
+	if(threadForces){
+		DemField& dem(field->cast<DemField>());
+		if(dyn.linIx>=0 && (size_t)dyn.linIx<dem.threadForce.size() && dem.nodes[dyn.linIx].get()==node.get()){
+			dem.threadForce.add(dyn.linIx,F);
+			dem.threadTorque.add(dyn.linIx,xc.cross(F)+T);
+			return;
+		}
+	}
+	dyn.addForceTorque(F,xc.cross(F)+T);
 }
@@ -5,6 +5,7 @@
 #include<woo/pkg/dem/Particle.hpp>
 #include<woo/pkg/dem/Collision.hpp>
 #include<woo/pkg/dem/Contact.hpp>
+#include<woo/lib/base/openmp-accu.hpp>
 
 
 /* ***************************************** */
@@ -88,7 +89,43 @@ class ContactLoop: public Engine {
 	void reorderContacts();
 
 	// internal use only
-	void applyForceUninodal(const shared_ptr<Contact>& C, const Particle* p);
+	// with threadForces, accumulate into DemField::threadForce and DemField::threadTorque if the node is in DemField::nodes
+	void applyForceUninodal(const shared_ptr<Contact>& C, const Particle* p, bool threadForces=false);
+
+	// apply contact forces after the loop, in parallel, with results independent of the number of threads
+	void applyForcesDeterministic();
+	vector<Vector3r> detContactFT; // F and T on pA, F and T on pB, for each contact (by linIx)
+	vector<Vector3r> detParticleFT; // summary F and T for each particle (by id)
+	vector<char> detParticleHas; // whether the particle has summary force to be applied
+
+	// per-thread partial sums of stress (before division by volume)
+	OpenMPAccumulator<Matrix3r> stressAccu;
+	Matrix3r contactStress(const shared_ptr<Contact>& C, const Particle* pA, const Particle* pB) const;
+
+	// per-step flags passed to the contact kernels
+	struct StepFlags{ bool removeUnseen, doStress, deterministic, physNow, threadForces; };
+	// apply forces and accumulate stress for contact which is real after the law was called
+	void contactForcesStress(const shared_ptr<Contact>& C, Particle* pA, Particle* pB, const StepFlags& sf);
+	// process contacts at given indices (all contacts if ixs is NULL) with full dispatch
+	void runDispatched(const vector<size_t>* ixs, const StepFlags& sf);
+
+	/* contacts sharing the same (CGeomFunctor,CPhysFunctor,LawFunctor) triple; real contacts only */
+	struct ContactBucket{
+		CGeomFunctor* cg; CPhysFunctor* cp; LawFunctor* law;
+		// loop over ix calling functors directly; specialized for common functor types
+		void (ContactLoop::*kernel)(const ContactBucket&, const StepFlags&);
+		vector<size_t> ix;
+	};
+	vector<ContactBucket> buckets;
+	vector<size_t> dispatchedIx;
+	vector<int> bucketOf;
+	vector<Functor*> bucketFunctors; // functors of dispatchers when buckets were created
+	unsigned bucketStamp=0; // matches Contact::loopBucketStamp if Contact::loopBucket is valid
+	void bucketsInvalidate();
+	vector<Functor*> dispatcherFunctors() const;
+	int contactBucket(const shared_ptr<Contact>& C);
+	template<class CgT, class LawT> void runBucket(const ContactBucket& b, const StepFlags& sf);
+	py::list pyBuckets() const;
 
 	public:
 		virtual void pyHandleCustomCtorArgs(py::tuple& t, py::dict& d) WOO_CXX11_OVERRIDE;
@@ -107,7 +144,7 @@ class ContactLoop: public Engine {
 
 	enum { UPDATE_PHYS_NEVER=0, UPDATE_PHYS_ALWAYS=1, UPDATE_PHYS_ONCE=2 };
 
-	#define woo_dem_ContactLoop__CLASS_BASE_DOC_ATTRS_CTOR \
+	#define woo_dem_ContactLoop__CLASS_BASE_DOC_ATTRS_CTOR_PY \
 		ContactLoop,Engine,"Loop over all contacts, possible in a parallel manner.\n\n.. admonition:: Special constructor\n\n\tConstructs from 3 lists of :obj:`Cg2 <CGeomFunctor>`, :obj:`Cp2 <IPhysFunctor>`, :obj:`Law <LawFunctor>` functors respectively; they will be passed to interal dispatchers.", \
 			((shared_ptr<CGeomDispatcher>,geoDisp,make_shared<CGeomDispatcher>(),AttrTrait<Attr::readonly>(),":obj:`CGeomDispatcher` object that is used for dispatch.")) \
 			((shared_ptr<CPhysDispatcher>,phyDisp,make_shared<CPhysDispatcher>(),AttrTrait<Attr::readonly>(),":obj:`CPhysDispatcher` object used for dispatch.")) \
@@ -124,11 +161,15 @@ class ContactLoop: public Engine {
 			/*((Real,prevTrGradVStress,NaN,AttrTrait<Attr::hidden>(),"Previous value of tr(gradV*stress)"))*/ \
 			((Matrix3r,prevStress,Matrix3r::Zero(),,"Previous value of stress, used to compute mid-step stress")) \
 			((int,gradVIx,-1,AttrTrait<Attr::hidden|Attr::noSave>(),"Cache energy index for gradV work")) \
+			((bool,bucketing,false,,"Group real contacts by the triple of functors (:obj:`CGeomFunctor`, :obj:`CPhysFunctor`, :obj:`LawFunctor`) which handle them and process each group in a separate loop, with functors resolved once per group rather than dispatched for every contact; common functor combinations (such as :obj:`Cg2_Sphere_Sphere_L6Geom` with :obj:`Law2_L6Geom_FrictPhys_IdealElPl`) are called non-virtually. Potential (non-real) contacts, and contacts for which some functor takes its arguments in swapped order, are always dispatched. Functor combination for each contact is cached and assumed not to change while the contact is real; all caches are invalidated when dispatcher functors change or when :obj:`updatePhys` is ``'once'``; with ``'always'``, material types of particles must not change while they are in contact (the :obj:`CPhysFunctor` of the cached group is used).")) \
+			((bool,threadForces,false,,"Accumulate contact forces in per-thread buffers (:obj:`DemField` internal storage) instead of locking :obj:`DemData` of each node; buffers are summed by :obj:`Leapfrog` right before forces are used (or at the end of this engine if there is no Leapfrog), and before nodes are removed. Nodes not in :obj:`DemField.nodes` are always updated directly. Ignored with :obj:`Scene.deterministic`. Forces in :obj:`DemData` are incomplete between this engine and Leapfrog.")) \
 			, /*ctor*/ \
 				woo_dem_ContactLoop__CTOR_timingDeltas \
-				woo_dem_ContactLoop__CTOR_removeAfterLoopRefs
+				woo_dem_ContactLoop__CTOR_removeAfterLoopRefs \
+			, /*py*/ \
+				.add_property("buckets",&ContactLoop::pyBuckets,"Contact buckets used in the last step with :obj:`bucketing`, as list of dicts with functor names, number of contacts and whether a specialized kernel is used.")
 
-	WOO_DECL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_ContactLoop__CLASS_BASE_DOC_ATTRS_CTOR);
+	WOO_DECL__CLASS_BASE_DOC_ATTRS_CTOR_PY(woo_dem_ContactLoop__CLASS_BASE_DOC_ATTRS_CTOR_PY);
 	WOO_DECL_LOGGER;
 };
 WOO_REGISTER_OBJECT(ContactLoop);
@@ -11,7 +11,7 @@ WOO_IMPL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_FrictPhys__CLASS_BASE_DOC_ATTRS_CTOR
 WOO_IMPL__CLASS_BASE_DOC_ATTRS(woo_dem_Cp2_FrictMat_FrictPhys__CLASS_BASE_DOC_ATTRS);
 
 void Cp2_FrictMat_FrictPhys::go(const shared_ptr<Material>& m1, const shared_ptr<Material>& m2, const shared_ptr<Contact>& C){
-	if(!C->phys) C->phys=make_shared<FrictPhys>();
+	if(!C->phys) C->phys=woo::slab_make_shared<FrictPhys>();
 	updateFrictPhys(m1->cast<FrictMat>(),m2->cast<FrictMat>(),C->phys->cast<FrictPhys>(),C);
 	//FrictPhys& ph=C->phys->cast<FrictPhys>();
 	//FrictMat& mat1=m1->cast<FrictMat>(); FrictMat& mat2=m2->cast<FrictMat>();
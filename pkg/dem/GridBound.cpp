@@ -34,7 +34,7 @@ bool GridBound::insideNodePlay(const shared_ptr<Shape>& s) const {
 #include<woo/pkg/dem/Sphere.hpp>
 
 void Grid1_Sphere::go(const shared_ptr<Shape>& sh, const Particle::id_t& id, const shared_ptr<GridCollider>& coll, const shared_ptr<GridStore>& grid){
-	if(scene->isPeriodic) throw std::logic_error("Grid1_Sphere: PBC not handled (yet)");
+	if(scene->isPeriodic){ goPeri(sh,id,coll,grid); return; }
 	Sphere& s=sh->cast<Sphere>();
 	if(!s.bound){ s.bound=make_shared<GridBound>(); }
 	assert(dynamic_pointer_cast<GridBound>(s.bound));
@@ -97,6 +97,58 @@ void Grid1_Sphere::go(const shared_ptr<Shape>& sh, const Particle::id_t& id, con
 	}
 }
 
+void Grid1_Sphere::goPeri(const shared_ptr<Shape>& sh, const Particle::id_t& id, const shared_ptr<GridCollider>& coll, const shared_ptr<GridStore>& grid){
+	Sphere& s=sh->cast<Sphere>();
+	if(!s.bound){ s.bound=make_shared<GridBound>(); }
+	assert(dynamic_pointer_cast<GridBound>(s.bound));
+	GridBound& gb=s.bound->cast<GridBound>();
+	#ifdef WOO_GRID_BOUND_DEBUG
+		gb.cells.clear();
+	#endif
+	const Cell& cell(*scene->cell);
+	const Vector3r& pos=s.nodes[0]->pos;
+	const auto& dyn(s.nodes[0]->getData<DemData>());
+	const Real& verletDist(coll->verletDist);
+	const int& verletSteps(coll->verletSteps);
+	Real radius=max(s.radius-coll->shrink,0.)+(distFactor>1?(distFactor-1):0.)*s.radius;
+	bool velSweep=(verletSteps>0 && (dyn.vel*verletSteps*scene->dt).squaredNorm()>pow(verletDist,2));
+	// the grid spans the unsheared cell; the node moves only within half of verletDist (the other half is for cell deformation)
+	AlignedBox3r nodePlay(pos-.5*verletDist*Vector3r::Ones(),pos+.5*verletDist*Vector3r::Ones());
+	if(velSweep) nodePlay.extend(AlignedBox3r(nodePlay).translate(dyn.vel*scene->dt*verletSteps));
+	AlignedBox3r nodeBox(cell.unshearPt(pos));
+	if(velSweep) nodeBox.extend(cell.unshearPt(pos+dyn.vel*scene->dt*verletSteps));
+	// enlarge so that the (sheared) sphere does not stick out of the box
+	const Real radiusVerletDist=radius+verletDist;
+	const Vector3r halfSize=cell.shearAlignedExtents(radiusVerletDist*Vector3r::Ones());
+	const AlignedBox3r bbox(nodeBox.min()-halfSize,nodeBox.max()+halfSize);
+	const Vector3r& size(cell.getSize());
+	// the nearest periodic image of a neighbour is then unambiguous (see GridCollider::tryAddContact)
+	if((bbox.sizes().array()>.5*size.array()).any()) throw std::runtime_error("Grid1_Sphere: #"+to_string(id)+" spans over half of the periodic cell size (decrease GridCollider.verletDist or GridCollider.verletSteps, or enlarge the cell).");
+	// round down also for negative coordinates, unlike GridStore::xyz2ijk
+	const Vector3i ijk0=((bbox.min()-grid->lo).array()/grid->cellSize.array()).floor().cast<int>().matrix();
+	Vector3i ijk1=((bbox.max()-grid->lo).array()/grid->cellSize.array()).floor().cast<int>().matrix();
+	const Vector3i& sizes(grid->gridSize);
+	// spanning all cells along some axis: don't visit wrapped cells twice, and don't test the distance from the cell
+	bool allCells=false;
+	for(int ax:{0,1,2}) if(ijk1[ax]-ijk0[ax]+1>=sizes[ax]){ ijk1[ax]=ijk0[ax]+sizes[ax]-1; allCells=true; }
+	// sheared sphere is not a sphere in the unsheared space anymore; only the box is used
+	const bool testDist=!allCells && !cell.hasShear();
+	for(Vector3i ijk=ijk0; ijk[0]<=ijk1[0]; ijk[0]++){
+		for(ijk[1]=ijk0[1]; ijk[1]<=ijk1[1]; ijk[1]++){
+			for(ijk[2]=ijk0[2]; ijk[2]<=ijk1[2]; ijk[2]++){
+				if(testDist && grid->boxCellDistSq(nodeBox,ijk)>pow(radiusVerletDist,2)) continue; // cell not touched by the sphere
+				Vector3i wrapped;
+				for(int ax:{0,1,2}) wrapped[ax]=((ijk[ax]%sizes[ax])+sizes[ax])%sizes[ax];
+				grid->protected_append(wrapped,id);
+				#ifdef WOO_GRID_BOUND_DEBUG
+					gb.cells.push_back(wrapped);
+				#endif
+			}
+		}
+	}
+	gb.setNodePlay_box0(sh,nodePlay);
+}
+
 void Grid1_Wall::go(const shared_ptr<Shape>& sh, const Particle::id_t& id, const shared_ptr<GridCollider>& coll, const shared_ptr<GridStore>& grid){
 	if(scene->isPeriodic) throw std::logic_error("Grid1_Wall: PBC not supported.");
 	Wall& w=sh->cast<Wall>();
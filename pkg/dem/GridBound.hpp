@@ -57,8 +57,10 @@ WOO_REGISTER_OBJECT(GridBoundDispatcher);
 #include<woo/pkg/dem/Sphere.hpp>
 struct Grid1_Sphere: public GridBoundFunctor{
 	void go(const shared_ptr<Shape>&, const Particle::id_t&, const shared_ptr<GridCollider>&, const shared_ptr<GridStore>&) WOO_CXX11_OVERRIDE;
+	// periodic boundaries: grid over the unsheared cell, with wrapped cell indices
+	void goPeri(const shared_ptr<Shape>&, const Particle::id_t&, const shared_ptr<GridCollider>&, const shared_ptr<GridStore>&);
 	FUNCTOR1D(Sphere);
-	WOO_CLASS_BASE_DOC_ATTRS(Grid1_Sphere,GridBoundFunctor,"Functor filling :obj:`GridStore` from :obj:`Sphere`, used with :obj:`GridCollider`.",
+	WOO_CLASS_BASE_DOC_ATTRS(Grid1_Sphere,GridBoundFunctor,"Functor filling :obj:`GridStore` from :obj:`Sphere`, used with :obj:`GridCollider`; supports periodic boundaries, including sheared cells.",
 		((Real,distFactor,((void)"deactivated",-1),,"Relative enlargement of the bounding box; deactivated if negative."))
 	);
 };
@@ -18,10 +18,15 @@ void GridCollider::getLabeledObjects(const shared_ptr<LabelMapper>& labelMapper)
 void GridCollider::postLoad(GridCollider&, void* attr){
 	if(domain.isEmpty() || domain.volume()==0) throw std::runtime_error("GridCollider.domain: may not be empty.");
 	if(!(minCellSize>0)) throw std::runtime_error("GridCollider.minCellSize: must be positive (not "+to_string(minCellSize));
-	dim=(domain.sizes()/minCellSize).cast<int>();
+	updateDim();
+	if(!boundDispatcher){ boundDispatcher=make_shared<GridBoundDispatcher>(); }
+}
+
+void GridCollider::updateDim(){
+	// at least one cell along each axis, even if the domain is smaller than minCellSize
+	dim=(domain.sizes()/minCellSize).cast<int>().cwiseMax(Vector3i::Ones());
 	cellSize=(domain.sizes().array()/dim.cast<Real>().array()).matrix();
 	shrink=around?cellSize.minCoeff()/2.:0.;
-	if(!boundDispatcher){ boundDispatcher=make_shared<GridBoundDispatcher>(); }
 }
 
 void GridCollider::selfTest(){
@@ -43,12 +48,19 @@ bool GridCollider::tryAddContact(const Particle::id_t& idA, const Particle::id_t
 		return false; // already in contact, nothing to do
 	}
 	LOG_TRACE("Creating new contact ##"<<idA<<"+"<<idB);
-	shared_ptr<Contact> newC=make_shared<Contact>();
+	shared_ptr<Contact> newC=woo::slab_make_shared<Contact>();
 	// mimick the way clDem::Collider does the job so that results are easily comparable
 	if(idA<idB){ newC->pA=pA; newC->pB=pB; }
 	else{ newC->pA=pB; newC->pB=pA; }
 	newC->stepCreated=scene->step;
 	newC->stepLastSeen=scene->step;
+	if(scene->isPeriodic){
+		// particles share a cell through wrapped indices, hence they are within half of the cell from each other
+		// in the unsheared space (checked by Grid1_Sphere); that gives the nearest periodic image of pB
+		const Vector3r dU=scene->cell->unshearPt(newC->leakPB()->shape->nodes[0]->pos-newC->leakPA()->shape->nodes[0]->pos);
+		const Vector3r& size(scene->cell->getSize());
+		for(int ax:{0,1,2}) newC->cellDist[ax]=-(int)std::round(dU[ax]/size[ax]);
+	}
 	// returns false if the contact exists (added by a different thread meanwhile)
 	return dem->contacts->add(newC,/*threadSafe*/true);
 }
@@ -89,12 +101,18 @@ bool GridCollider::allParticlesWithinPlay() const {
 	return true;
 }
 
+bool GridCollider::cellOutsidePlay() const {
+	// bound on the shift of periodic images of neighbouring particles, and on the distortion of the unsheared space
+	const Matrix3r dH=scene->cell->hSize-hSizeLast;
+	return dH.col(0).norm()+dH.col(1).norm()+dH.col(2).norm()>.5*verletDist;
+}
+
 void GridCollider::prepareGridCurr(){
 	// recycle to avoid re-allocations (expensive)
 	std::swap(gridPrev,gridCurr);
 	// if some parameters differ, make a new one
-	if(!gridCurr || gridCurr->sizes()!=dim || gridCurr->cellLen!=gridDense || gridCurr->exIniSize!=exIniSize || gridCurr->exNumMaps!=exNumMaps){
-		gridCurr=make_shared<GridStore>(dim,gridDense,/*locking*/true,exIniSize,exNumMaps);
+	if(!gridCurr || gridCurr->sizes()!=dim || gridCurr->csr!=csr || gridCurr->cellLen!=gridDense || gridCurr->exIniSize!=exIniSize || gridCurr->exNumMaps!=exNumMaps){
+		gridCurr=make_shared<GridStore>(dim,gridDense,/*locking*/!csr,exIniSize,exNumMaps,csr);
 		LOG_WARN("Allocated new GridStore.");
 	} else {
 		gridCurr->clear();
@@ -118,6 +136,8 @@ void GridCollider::fillGridCurr(){
 		// when not in diffStep, add all particles, even if within their nodePlay boxes
 		boundDispatcher->operator()(p->shape,p->id,shared_this,gridCurr);
 	}
+	// merge items collected by threads (count, then fill)
+	if(gridCurr->csr) gridCurr->csrBuild();
 }
 
 void GridCollider::run(){
@@ -132,6 +152,7 @@ void GridCollider::run(){
 	dem->contacts->clearPending();
 
 	bool allOk=allParticlesWithinPlay();
+	if(allOk && scene->isPeriodic && cellOutsidePlay()) allOk=false;
 	// if dirty, clear the dirty flag and do a full run
 	if(dem->contacts->dirty){ allOk=false; dem->contacts->dirty=false; }
 	GC_CHECKPOINT("check-play");
@@ -140,6 +161,13 @@ void GridCollider::run(){
 	/*** FULL COLLIDER RUN ***/
 	nFullRuns++;
 
+	if(scene->isPeriodic){
+		// grid over the unsheared cell; particles are stored in cells with wrapped indices
+		domain=AlignedBox3r(Vector3r::Zero(),scene->cell->getSize());
+		updateDim();
+		hSizeLast=scene->cell->hSize;
+	}
+
 	prepareGridCurr(); GC_CHECKPOINT("prepare-grid");
 	bool diffStep=(useDiff && gridPrev && gridPrev->isCompatible(gridCurr));
 	
@@ -40,6 +40,10 @@ struct GridCollider: public Collider{
 	bool tryDeleteContact(const Particle::id_t& idA, const Particle::id_t& idB) const;
 
 	bool allParticlesWithinPlay() const;
+	// compute dim and cellSize from domain and minCellSize
+	void updateDim();
+	// with periodic boundaries, whether the cell changed too much since the last full run
+	bool cellOutsidePlay() const;
 	void prepareGridCurr();
 	void fillGridCurr();
 
@@ -50,9 +54,9 @@ struct GridCollider: public Collider{
 	void invalidatePersistentData() WOO_CXX11_OVERRIDE { gridPrev.reset(); }
 
 	#define woo_dem_GridCollider__CLASS_BASE_DOC_ATTRS \
-		GridCollider,Collider,ClassTrait().doc("Grid-based collider.").section("","",{"GridStore"}), \
+		GridCollider,Collider,ClassTrait().doc("Grid-based collider.\n\nWith periodic boundaries, the grid spans the (unsheared) periodic cell, overriding :obj:`domain`; cell indices wrap around, and :obj:`Contact.cellDist` of new contacts is determined from the minimum image of particle positions. Particles move only within one half of :obj:`verletDist` before a full run is triggered, the other half is left for the change of the cell (:obj:`Cell.hSize`, including shear) since the last full run. Only spheres (:obj:`Grid1_Sphere`) are supported in periodic scenes.").section("","",{"GridStore"}), \
 		/* grid definition */ \
-		((AlignedBox3r,domain,AlignedBox3r(Vector3r::Zero(),Vector3r::Ones()),AttrTrait<Attr::triggerPostLoad>().startGroup("Grid geometry"),"Domain spanned by the grid.")) \
+		((AlignedBox3r,domain,AlignedBox3r(Vector3r::Zero(),Vector3r::Ones()),AttrTrait<Attr::triggerPostLoad>().startGroup("Grid geometry"),"Domain spanned by the grid; with periodic boundaries, set automatically to the unsheared cell at every full run.")) \
 		((Real,minCellSize,1.,AttrTrait<Attr::triggerPostLoad>(),"Minimum cell size which will be used to compute :obj:`dim`.")) \
 		((Vector3i,dim,Vector3i(-1,-1,-1),AttrTrait<Attr::readonly>(),"Number of cells along each axis")) \
 		((Vector3r,cellSize,Vector3r(NaN,NaN,NaN),AttrTrait<Attr::readonly>(),"Actual cell size")) \
@@ -62,6 +66,7 @@ struct GridCollider: public Collider{
 		((shared_ptr<GridStore>,gridCurr,,AttrTrait<Attr::noSave>(),"Current fully populated grid.")) \
 		((shared_ptr<GridStore>,gridOld,,AttrTrait<Attr::noSave>(),"Grid containing entries in :obj:`gridPrev` but not in :obj:`gridCurr`.")) \
 		((shared_ptr<GridStore>,gridNew,,AttrTrait<Attr::noSave>(),"Grid containing entries in :obj:`gridCurr` but not in :obj:`gridPrev`.")) \
+		((Matrix3r,hSizeLast,Matrix3r::Zero(),AttrTrait<Attr::readonly|Attr::noSave>(),"Value of :obj:`Cell.hSize` at the last full run (only used with periodic boundaries).")) \
 		/* rendering */ \
 		((Vector3r,color,Vector3r(1,1,0),AttrTrait<>().rgbColor().startGroup("Rendering"),"Color for rendering the domain")) \
 		((bool,renderCells,false,,"Render cells.")) \
@@ -71,6 +76,7 @@ struct GridCollider: public Collider{
 		((int,gridDense,6,AttrTrait<>().startGroup("Tunables"),"Length of dense storage for new :obj:`GridStore` objects.")) \
 		((int,exIniSize,6,,":obj:`GridStore.exIniSize` for new grids.")) \
 		((int,exNumMaps,100,,":obj:`GridStore.exNumMaps` for new grids.")) \
+		((bool,csr,true,,"Use :obj:`GridStore.csr` grids, filled without locking in two passes (count, then fill); otherwise, use dense storage with per-cell mutexes (:obj:`gridDense`, :obj:`exIniSize` and :obj:`exNumMaps` only apply to the latter).")) \
 		((Real,verletDist,0,AttrTrait<>().lenUnit(),"Length by which particle size is enalrged, to avoid running the collider at every timestep.")) \
 		((int,verletSteps,0,,"If positive, enlarge boxes of some particle nodes (currently only spheres are supported) so that they will still be inside the box after *verletSteps* with their current velocity; :obj:`verletDist` is still used when velocity is too small.")) \
 		((int,nFullRuns,0,AttrTrait<>(),"Cumulative number of full runs, when collision detection is needed.")) \
@@ -4,20 +4,26 @@
 #include<woo/pkg/dem/GridCollider.hpp> // for timing macro GC_CHECKPOINT2
 #include<boost/function_output_iterator.hpp>
 #include<boost/range/algorithm/set_algorithm.hpp>
+#include<numeric>
 
 WOO_PLUGIN(dem,(GridStore));
 
 WOO_IMPL_LOGGER(GridStore);
 
 
-GridStore::GridStore(const Vector3i& _gridSize, int _cellLen, bool _denseLock, int _exIniSize, int _exNumMaps): gridSize(_gridSize), cellLen(_cellLen), denseLock(_denseLock), exIniSize(_exIniSize), exNumMaps(_exNumMaps){
+GridStore::GridStore(const Vector3i& _gridSize, int _cellLen, bool _denseLock, int _exIniSize, int _exNumMaps, bool _csr): gridSize(_gridSize), cellLen(_cellLen), denseLock(_denseLock), exIniSize(_exIniSize), exNumMaps(_exNumMaps), csr(_csr){
 	postLoad(*this,NULL);
 }
 
 void GridStore::postLoad(GridStore&,void* I){
 	if(I!=NULL) throw std::logic_error("GridStore::postLoad: called after a variable was set. Which one!?");
-	if(grid) return; // everything is set up already, this is a spurious call
+	if(grid || !csrStart.empty()) return; // everything is set up already, this is a spurious call
 	if(gridSize.minCoeff()<=0) throw std::logic_error("GridStore.gridSize: all dimensions must be positive.");
+	if(csr){
+		csrStart.assign(gridSize.prod()+1,0);
+		csrPendingReset();
+		return;
+	}
 	if(cellLen<=1) throw std::logic_error("GridStore.cellLen must be greater than one.");
 	if(exNumMaps<=0) throw std::logic_error("GridStore.exNumMaps must be positive.");
 	if(exIniSize<=0) throw std::logic_error("GridStore.exIniSize must be positive.");
@@ -65,12 +71,19 @@ Vector3r GridStore::xyzNearIjk(const Vector3i& from, const Vector3i& ijk) const{
 bool GridStore::isCompatible(shared_ptr<GridStore>& other){
 	// if grid dimension matches, tht is all we need
 	if(this->sizes()!=other->sizes()) return false;
+	if(this->csr!=other->csr) return false;
 	if(this->lo!=other->lo) return false;
 	if(this->cellSize!=other->cellSize) return false;
 	return true;
 }
 
 void GridStore::makeCompatible(shared_ptr<GridStore>& g, int l, bool _denseLock, int _exIniSize, int _exNumMaps) const {
+	if(csr){
+		// no storage parameters besides the size
+		if(!g || !g->csr || gridSize!=g->gridSize) g=make_shared<GridStore>(gridSize,cellLen,/*denseLock*/false,exIniSize,exNumMaps,/*csr*/true);
+		g->lo=lo; g->cellSize=cellSize;
+		return;
+	}
 	auto shape=grid->shape();
 	l=l>0?l:shape[3]; // set to the real desired value of l
 	assert(l>0);
@@ -92,6 +105,12 @@ void GridStore::makeCompatible(shared_ptr<GridStore>& g, int l, bool _denseLock,
 }
 
 void GridStore::clear() {
+	if(csr){
+		std::fill(csrStart.begin(),csrStart.end(),0);
+		csrIds.clear();
+		csrPendingReset();
+		return;
+	}
 	// TODO: get id_t as a typedef from inside gridT?
 	std::memset((void*)grid->data(),0,grid->num_elements()*sizeof(id_t)); 
 	// std::fill(grid->origin(),grid->origin()+grid->num_elements(),0);
@@ -99,6 +118,7 @@ void GridStore::clear() {
 };
 
 void GridStore::clear_ex() {
+	if(csr) return;
 	// don't forget the reference here!
 	for(auto& gridEx: gridExx) gridEx.clear();
 	#if 0
@@ -122,6 +142,7 @@ GridStore::gridExT& GridStore::getGridEx(const Vector3i& ijk) {
 
 void GridStore::protected_append(const Vector3i& ijk, const GridStore::id_t& id){
 	checkIndices(ijk);
+	if(csr){ append(ijk,id); return; }
 	assert(denseLock);
 	boost::mutex::scoped_lock lock(*getMutex</*mutexEx*/false>(ijk));
 	append(ijk,id);
@@ -129,6 +150,14 @@ void GridStore::protected_append(const Vector3i& ijk, const GridStore::id_t& id)
 
 void GridStore::append(const Vector3i& ijk, const GridStore::id_t& id, bool noSizeInc){
 	checkIndices(ijk);
+	if(csr){
+		#ifdef WOO_OPENMP
+			csrPending[omp_get_thread_num()].push_back(std::make_pair(ijk2lin(ijk),id));
+		#else
+			csrPending[0].push_back(std::make_pair(ijk2lin(ijk),id));
+		#endif
+		return;
+	}
 	const int& i(ijk[0]), &j(ijk[1]), &k(ijk[2]);
 	// 0th element is the number of elements
 	// it is fetched and incremented atomically
@@ -188,15 +217,94 @@ void GridStore::append(const Vector3i& ijk, const GridStore::id_t& id, bool noSi
 
 void GridStore::clear_dense(const Vector3i& ijk){
 	checkIndices(ijk);
+	assert(!csr);
 	(*grid)[ijk[0]][ijk[1]][ijk[2]][0]=0;
 }
 
+void GridStore::csrBuild(){
+	assert(csr);
+	size_t nPending=0;
+	for(const auto& pending: csrPending) nPending+=pending.size();
+	if(nPending==0){ csrPendingReset(); return; }
+	const long N=linSize();
+	// count: items already stored, plus pending ones
+	vector<size_t> start(N+1);
+	start[0]=0;
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long n=0; n<N; n++) start[n+1]=csrStart[n+1]-csrStart[n];
+	#ifdef WOO_OPENMP
+		#pragma omp parallel
+	#endif
+	for(const auto& pending: csrPending){
+		const long sz=pending.size();
+		#ifdef WOO_OPENMP
+			#pragma omp for schedule(static) nowait
+		#endif
+		for(long i=0; i<sz; i++){
+			#ifdef WOO_OPENMP
+				#pragma omp atomic
+			#endif
+			start[pending[i].first+1]++;
+		}
+	}
+	std::partial_sum(start.begin(),start.end(),start.begin());
+	// fill: items already stored first, then pending ones at atomically reserved positions
+	vector<id_t> ids(start[N]);
+	vector<size_t> fill(N);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long n=0; n<N; n++){
+		fill[n]=start[n]+std::copy(csrIds.begin()+csrStart[n],csrIds.begin()+csrStart[n+1],ids.begin()+start[n])-(ids.begin()+start[n]);
+	}
+	#ifdef WOO_OPENMP
+		#pragma omp parallel
+	#endif
+	for(const auto& pending: csrPending){
+		const long sz=pending.size();
+		#ifdef WOO_OPENMP
+			#pragma omp for schedule(static) nowait
+		#endif
+		for(long i=0; i<sz; i++){
+			size_t pos;
+			#ifdef WOO_OPENMP
+				#pragma omp atomic capture
+			#endif
+			pos=fill[pending[i].first]++;
+			ids[pos]=pending[i].second;
+		}
+	}
+	// the order of pending items depends on thread scheduling
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(guided)
+	#endif
+	for(long n=0; n<N; n++){
+		if(start[n+1]-start[n]>1) std::sort(ids.begin()+start[n],ids.begin()+start[n+1]);
+	}
+	csrStart.swap(start);
+	csrIds.swap(ids);
+	csrPendingReset();
+}
+
+void GridStore::csrPendingReset(){
+	for(auto& pending: csrPending) pending.clear();
+	#ifdef WOO_OPENMP
+		if((int)csrPending.size()!=omp_get_max_threads()) csrPending.resize(omp_get_max_threads());
+	#else
+		csrPending.resize(1);
+	#endif
+}
+
 void GridStore::pyAppend(const Vector3i& ijk, GridStore::id_t id) {
-	if(denseLock) protected_append(ijk, id);
+	if(csr){ append(ijk,id); csrBuild(); }
+	else if(denseLock) protected_append(ijk, id);
 	else append(ijk,id);
 }
 
 void GridStore::pyDelItem(const Vector3i& ijk){
+	if(csr) throw std::runtime_error("GridStore.__delitem__: not supported with GridStore.csr.");
 	if(denseLock){ boost::mutex::scoped_lock(*getMutex</*mutexEx*/false>(ijk)); clear_dense(ijk); }
 	else clear_dense(ijk);
 	boost::mutex::scoped_lock(*getMutex</*mutexEx*/true>(ijk));
@@ -241,6 +349,7 @@ vector<int> GridStore::pyCounts() const{
 }
 
 py::tuple GridStore::pyRawData(const Vector3i& ijk){
+	if(csr) return py::make_tuple(pyGetItem(ijk),py::list());
 	py::list dense;
 	for(int l=0; l<(int)grid->shape()[3]; l++) dense.append((*grid)[ijk[0]][ijk[1]][ijk[2]][l]);
 	auto& gridEx=getGridEx(ijk);
@@ -270,6 +379,8 @@ void GridStore::complements(const shared_ptr<GridStore>& _B, shared_ptr<GridStor
 		throw std::runtime_error(oss.str());
 	}
 	assert(A.gridSize==B.gridSize);
+	if(A.csr!=B.csr) throw std::runtime_error("GridStore::complements: GridStore.csr mismatch.");
+	if(csr){ csrComplements(B,A_B,B_A); GC_CHECKPOINT2("rel-compl-end"); return; }
 	// use the same value of L for now
 	makeCompatible(A_B,/*denseLock*/false); makeCompatible(B_A,/*denseLock*/false);
 	// clear extra storage; dense storage is cleared in the parallel section for every cell separately
@@ -320,3 +431,39 @@ void GridStore::complements(const shared_ptr<GridStore>& _B, shared_ptr<GridStor
 	GC_CHECKPOINT2("rel-compl-end");
 }
 
+void GridStore::csrComplements(const GridStore& B, shared_ptr<GridStore>& A_B, shared_ptr<GridStore>& B_A) const {
+	const GridStore& A(*this);
+	makeCompatible(A_B); makeCompatible(B_A);
+	const long N=linSize();
+	vector<size_t>& sAB(A_B->csrStart); vector<size_t>& sBA(B_A->csrStart);
+	sAB.assign(N+1,0); sBA.assign(N+1,0);
+	A_B->csrPendingReset(); B_A->csrPendingReset();
+	// count: merge of sorted cells
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(guided)
+	#endif
+	for(long n=0; n<N; n++){
+		auto a=A.csrIds.begin()+A.csrStart[n], aEnd=A.csrIds.begin()+A.csrStart[n+1];
+		auto b=B.csrIds.begin()+B.csrStart[n], bEnd=B.csrIds.begin()+B.csrStart[n+1];
+		size_t nAB=0, nBA=0;
+		while(a!=aEnd && b!=bEnd){
+			if(*a<*b){ nAB++; a++; }
+			else if(*b<*a){ nBA++; b++; }
+			else { a++; b++; }
+		}
+		sAB[n+1]=nAB+(aEnd-a); sBA[n+1]=nBA+(bEnd-b);
+	}
+	std::partial_sum(sAB.begin(),sAB.end(),sAB.begin());
+	std::partial_sum(sBA.begin(),sBA.end(),sBA.begin());
+	// fill: each cell writes its own range
+	A_B->csrIds.resize(sAB[N]); B_A->csrIds.resize(sBA[N]);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(guided)
+	#endif
+	for(long n=0; n<N; n++){
+		auto a=A.csrIds.begin()+A.csrStart[n], aEnd=A.csrIds.begin()+A.csrStart[n+1];
+		auto b=B.csrIds.begin()+B.csrStart[n], bEnd=B.csrIds.begin()+B.csrStart[n+1];
+		std::set_difference(a,aEnd,b,bEnd,A_B->csrIds.begin()+sAB[n]);
+		std::set_difference(b,bEnd,a,aEnd,B_A->csrIds.begin()+sBA[n]);
+	}
+}
@@ -19,6 +19,11 @@
 
 	Each cell might be protected by a mutex for writing, as well as each map ijk->ids (protected_append).
 
+	In the CSR mode (csr), there is no dense storage, maps or mutexes: appended items are collected in per-thread
+	buffers without locking, and csrBuild merges them into compressed arrays in two passes (count items per cell,
+	then fill at offsets given by the prefix sum of counts); ids within each cell are sorted. Items are only
+	visible after csrBuild.
+
 */
 struct GridStore: public Object{
 	typedef Particle::id_t id_t;
@@ -30,6 +35,15 @@ struct GridStore: public Object{
 	std::unique_ptr<gridT> grid;
 	vector<gridExT> gridExx;
 	mutexesT mutexes;
+	// CSR mode: ids in cell with linear index n are csrIds[csrStart[n]..csrStart[n+1]-1]
+	vector<size_t> csrStart;
+	vector<id_t> csrIds;
+	// items appended since the last csrBuild, for each thread (linear index, id)
+	vector<vector<std::pair<size_t,id_t>>> csrPending;
+	// merge pending items into csrStart and csrIds
+	void csrBuild();
+	// empty pending items, with one vector for each thread (the number of threads may change between steps)
+	void csrPendingReset();
 
 	// obtain gridEx for given cell
 	const gridExT& getGridEx(const Vector3i& ijk) const;
@@ -38,11 +52,11 @@ struct GridStore: public Object{
 
 	/* inlined one-liners */
 	// convert linear index to grid indices
-	Vector3i lin2ijk(size_t n) const { const auto& shape=grid->shape(); return Vector3i(n/(shape[1]*shape[2]),(n%(shape[1]*shape[2]))/shape[2],(n%(shape[1]*shape[2]))%shape[2]); }
+	Vector3i lin2ijk(size_t n) const { const size_t s12=gridSize[1]*gridSize[2]; return Vector3i(n/s12,(n%s12)/gridSize[2],(n%s12)%gridSize[2]); }
 	// convert grid indices to linear index
-	size_t ijk2lin(const Vector3i& ijk) const { const auto& shape=grid->shape(); return ijk[0]*shape[1]*shape[2]+ijk[1]*shape[2]+ijk[2]; }
+	size_t ijk2lin(const Vector3i& ijk) const { return (size_t(ijk[0])*gridSize[1]+ijk[1])*gridSize[2]+ijk[2]; }
 	// return 3d grid sizes (upper bound of grid indices)
-	Vector3i sizes() const { return Vector3i(grid->shape()[0],grid->shape()[1],grid->shape()[2]); }
+	Vector3i sizes() const { return gridSize; }
 	// return grid storage size (upper bound of linear index)
 	size_t linSize() const { return sizes().prod(); }
 	// return false if the given index is out of range
@@ -81,8 +95,8 @@ struct GridStore: public Object{
 		if there is nothing
 	*/
 
-	// ctor; allocate grid and locks (if desired)
-	GridStore(const Vector3i& ijk, int l, bool locking, int _exIniSize, int _exNumMaps);
+	// ctor; allocate grid and locks (if desired), or CSR arrays
+	GridStore(const Vector3i& ijk, int l, bool locking, int _exIniSize, int _exNumMaps, bool _csr=false);
 
 	void postLoad(GridStore&,void*);
 	
@@ -109,18 +123,19 @@ struct GridStore: public Object{
 
 	// inlined, disappears in optimized builds (no-op)
 	void checkIndices(const Vector3i& ijk) const {
-		assert(grid->shape()[0]==(size_t)gridSize[0]);
-		assert(grid->shape()[1]==(size_t)gridSize[1]);
-		assert(grid->shape()[2]==(size_t)gridSize[2]);
-		assert(ijk[0]>=0); assert(ijk[0]<(int)grid->shape()[0]);
-		assert(ijk[1]>=0); assert(ijk[1]<(int)grid->shape()[1]);
-		assert(ijk[2]>=0); assert(ijk[2]<(int)grid->shape()[2]);
+		assert(csr || grid->shape()[0]==(size_t)gridSize[0]);
+		assert(csr || grid->shape()[1]==(size_t)gridSize[1]);
+		assert(csr || grid->shape()[2]==(size_t)gridSize[2]);
+		assert(ijk[0]>=0); assert(ijk[0]<gridSize[0]);
+		assert(ijk[1]>=0); assert(ijk[1]<gridSize[1]);
+		assert(ijk[2]>=0); assert(ijk[2]<gridSize[2]);
 	}
 
 
 	// thread safe: clear dense storage (set count to 0), don't touch extra storage
 	void clear_dense(const Vector3i& ijk);
 	// thread unsafe: add element to the cell (in grid, or, if full, in gridEx)
+	// in the CSR mode, thread safe (collected in per-thread buffer)
 	// noSizeInc only used internally
 	void append(const Vector3i& ijk, const id_t&, bool noSizeInc=false);
 	// thread safe: lock (always) and append
@@ -138,12 +153,15 @@ struct GridStore: public Object{
 	*/
 	void complements(const shared_ptr<GridStore>& B, shared_ptr<GridStore>& A_B, shared_ptr<GridStore>& B_A, const int& setMinSize=-1, const shared_ptr<TimingDeltas>& timingDeltas=shared_ptr<TimingDeltas>()) const;
 	py::tuple pyComplements(const shared_ptr<GridStore>& B, const int& setMinSize=-1) const;
+	// the same in the CSR mode: cells are sorted, hence counted and filled by merging, in two passes
+	void csrComplements(const GridStore& B, shared_ptr<GridStore>& A_B, shared_ptr<GridStore>& B_A) const;
 
 	/* put those get() and size() inline, since they are used rather frequently */
 
 	// return i-th element, from grid or gridEx depending on l
 	inline const id_t& get(const Vector3i& ijk, const int& l) const{
 		checkIndices(ijk); assert(l>=0);
+		if(csr){ assert(l<(int)size(ijk)); return csrIds[csrStart[ijk2lin(ijk)]+l]; }
 		const int& i(ijk[0]), &j(ijk[1]), &k(ijk[2]);
 		const int denseSz=grid->shape()[3]-1; // first item is total cell size
 		assert(l<(int)size(ijk));
@@ -161,6 +179,7 @@ struct GridStore: public Object{
 	// return number of elements in grid+gridEx
 	size_t size(const Vector3i& ijk) const{
 		checkIndices(ijk);
+		if(csr){ const size_t n=ijk2lin(ijk); return csrStart[n+1]-csrStart[n]; }
 		const int cellSz=(*grid)[ijk[0]][ijk[1]][ijk[2]][0];
 		return cellSz;
 	}
@@ -186,6 +205,7 @@ struct GridStore: public Object{
 		((bool,denseLock,true,AttrTrait<>().readonly(),"Whether this grid supports per-cell dense storage locking for appending (must use protected_append)"))
 		((int,exIniSize,4,AttrTrait<>().readonly(),"Initial size of extension vectors, and step of their growth if needed."))
 		((int,exNumMaps,10,AttrTrait<>().readonly(),"Number of maps for extra items not fitting the dense storage (it affects how fine-grained is locking for those extra elements)"))
+		((bool,csr,false,AttrTrait<>().readonly(),"Store cells in compressed arrays (offsets and ids), built in two passes (count, then fill) from items appended without locking; there is no dense storage, extra maps or mutexes, and ids in each cell are sorted. Appended items are visible after the grid is built (done automatically when appending from python)."))
 		((Vector3r,lo,Vector3r(NaN,NaN,NaN),,"Lower corner of the domain."))
 		((Vector3r,cellSize,Vector3r(NaN,NaN,NaN),,"Spatial size of the grid cell."))
 		, /*ctor*/
@@ -0,0 +1,245 @@
+#include<woo/pkg/dem/HierGridCollider.hpp>
+#include<woo/pkg/dem/ParticleContainer.hpp>
+#include<woo/pkg/dem/Sphere.hpp>
+#include<woo/lib/base/SlabPool.hpp>
+
+WOO_PLUGIN(dem,(HierGridCollider));
+WOO_IMPL_LOGGER(HierGridCollider);
+WOO_IMPL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_HierGridCollider__CLASS_BASE_DOC_ATTRS_CTOR);
+
+void HierGridCollider::pyHandleCustomCtorArgs(py::tuple& t, py::dict& d){
+	if(py::len(t)==0) return; // nothing to do
+	if(py::len(t)!=1) throw invalid_argument("HierGridCollider optionally takes exactly one list of BoundFunctor's as non-keyword argument for constructor ("+to_string(py::len(t))+" non-keyword ards given instead)");
+	if(!boundDispatcher) boundDispatcher=make_shared<BoundDispatcher>();
+	vector<shared_ptr<BoundFunctor>> vf=py::extract<vector<shared_ptr<BoundFunctor>>>((t[0]))();
+	for(const auto& f: vf) boundDispatcher->add(f);
+	t=py::tuple(); // empty the args
+}
+
+void HierGridCollider::getLabeledObjects(const shared_ptr<LabelMapper>& labelMapper){ if(boundDispatcher) boundDispatcher->getLabeledObjects(labelMapper); Engine::getLabeledObjects(labelMapper); }
+
+bool HierGridCollider::shouldBeRemoved(const shared_ptr<Contact>& C, Scene* scene) const {
+	if(C->pA.expired() || C->pB.expired()) return true; // remove contact where constituent particles have been deleted
+	Particle::id_t idA=C->leakPA()->id, idB=C->leakPB()->id;
+	if(max(idA,idB)>=(Particle::id_t)boxes.size()) return true;
+	return !boxesOverlap(idA,idB);
+}
+
+Vector3i HierGridCollider::clampedCell(const GridStore& g, const Vector3r& x) const {
+	Vector3i ret;
+	// clamp in Real before converting, so that far-away (or infinite) coordinates don't overflow
+	for(int ax:{0,1,2}) ret[ax]=(int)std::min(std::max((x[ax]-g.lo[ax])/g.cellSize[ax],(Real)0.),(Real)(g.gridSize[ax]-1));
+	return ret;
+}
+
+void HierGridCollider::setupLevels(){
+	// domain and size range of finite bounds
+	AlignedBox3r extent; Real minSize=Inf, maxSize=0.;
+	for(size_t id=0; id<boxes.size(); id++){
+		if(parLevel[id]<0) continue;
+		const AlignedBox3r& b(boxes[id]);
+		if(!b.min().allFinite() || !b.max().allFinite()) continue;
+		extent.extend(b);
+		Real sz=b.sizes().maxCoeff();
+		if(sz>0) minSize=min(minSize,sz);
+		maxSize=max(maxSize,sz);
+	}
+	if(domain.isEmpty()){
+		if(extent.isEmpty()) return; // nothing finite at all, everything will be checked against everything
+		domain=extent;
+		LOG_DEBUG("HierGridCollider.domain set to "<<domain.min().transpose()<<", "<<domain.max().transpose());
+	}
+	else if(domainGrow>=0 && !extent.isEmpty() && !domain.contains(extent)){
+		// enlarge with some margin, so that steadily spreading particles don't make grids rebuilt at every full run
+		domain.extend(extent);
+		const Vector3r margin=domainGrow*domain.sizes();
+		domain=AlignedBox3r(domain.min()-margin,domain.max()+margin);
+		LOG_DEBUG("HierGridCollider.domain enlarged to "<<domain.min().transpose()<<", "<<domain.max().transpose());
+	}
+	Real h0=(minCellSize>0?minCellSize:(isinf(minSize)?domain.sizes().maxCoeff():minSize));
+	// cap the number of cells
+	Vector3r dSz=domain.sizes().cwiseMax(Vector3r::Constant(h0*1e-3));
+	while((dSz/h0).array().ceil().prod()>maxCells) h0*=levelRatio;
+	if(!(levelRatio>1)) throw std::runtime_error("HierGridCollider.levelRatio: must be greater than 1 (not "+to_string(levelRatio)+").");
+	if(maxLevels<1) throw std::runtime_error("HierGridCollider.maxLevels: must be positive.");
+	nLevels=1;
+	while(nLevels<maxLevels && h0*pow(levelRatio,nLevels-1)<maxSize) nLevels++;
+	grids.resize(nLevels);
+	for(int l=0; l<nLevels; l++){
+		Real h=h0*pow(levelRatio,l);
+		Vector3i dim=(dSz/h).array().ceil().cast<int>().matrix().cwiseMax(Vector3i::Ones());
+		shared_ptr<GridStore>& g(grids[l]);
+		// grids are filled serially, hence without per-cell locks
+		if(!g || g->sizes()!=dim || g->cellLen!=gridDense || g->exIniSize!=exIniSize || g->exNumMaps!=exNumMaps) g=make_shared<GridStore>(dim,gridDense,/*locking*/false,exIniSize,exNumMaps);
+		else g->clear();
+		g->lo=domain.min();
+		g->cellSize=Vector3r::Constant(h);
+	}
+}
+
+void HierGridCollider::tryContact(const Particle::id_t& a, const Particle::id_t& b){
+	if(!boxesOverlap(a,b)) return;
+	const auto& pA((*dem->particles)[a]); const auto& pB((*dem->particles)[b]);
+	if(!Collider::mayCollide(dem,pA,pB)) return;
+	const shared_ptr<Contact>& C=dem->contacts->find(a,b);
+	// every pair is visited once, so this write does not race
+	if(C){ C->stepLastSeen=scene->step; return; }
+	shared_ptr<Contact> newC=woo::slab_make_shared<Contact>();
+	if(a<b){ newC->pA=pA; newC->pB=pB; }
+	else { newC->pA=pB; newC->pB=pA; }
+	newC->stepCreated=scene->step;
+	newC->stepLastSeen=scene->step;
+	#ifdef WOO_OPENMP
+		thNewContacts[omp_get_thread_num()].push_back(newC);
+	#else
+		thNewContacts[0].push_back(newC);
+	#endif
+}
+
+void HierGridCollider::addNewContacts(){
+	ContactContainer& cc(*dem->contacts);
+	#if defined(WOO_OPENMP) || defined(WOO_OPENGL)
+		boost::mutex::scoped_lock lock(cc.manipMutex);
+	#endif
+	size_t nNew=0;
+	for(const auto& nn: thNewContacts) nNew+=nn.size();
+	#ifdef WOO_OPENMP
+		if(!scene->deterministic && nNew>=(size_t)paraAddMin){
+			cc.beginConcurrent(nNew);
+			#pragma omp parallel
+			for(const auto& nn: thNewContacts){
+				const long sz=nn.size();
+				#pragma omp for schedule(static) nowait
+				for(long i=0; i<sz; i++) cc.addConcurrent(nn[i]);
+			}
+			cc.endConcurrent();
+			for(auto& nn: thNewContacts) nn.clear();
+			return;
+		}
+	#endif
+	if(scene->deterministic){
+		// the order in which threads found contacts depends on scheduling
+		vector<shared_ptr<Contact>> all; all.reserve(nNew);
+		for(auto& nn: thNewContacts){ all.insert(all.end(),nn.begin(),nn.end()); nn.clear(); }
+		std::sort(all.begin(),all.end(),[](const shared_ptr<Contact>& a, const shared_ptr<Contact>& b){
+			return std::make_pair(a->leakPA()->id,a->leakPB()->id)<std::make_pair(b->leakPA()->id,b->leakPB()->id);
+		});
+		for(const auto& C: all) cc.addMaybe_fast(C);
+		return;
+	}
+	for(auto& nn: thNewContacts){
+		for(const auto& C: nn) cc.addMaybe_fast(C);
+		nn.clear();
+	}
+}
+
+void HierGridCollider::run(){
+	dem=static_cast<DemField*>(field.get());
+	if(scene->isPeriodic) throw std::runtime_error("HierGridCollider: periodic boundaries are not supported.");
+	boundDispatcher->scene=scene;
+	boundDispatcher->field=field;
+	boundDispatcher->updateScenePtr();
+
+	// automatically initialize from min sphere size; if no spheres, disable stride
+	if(verletDist<0){
+		Real minR=Inf;
+		for(const shared_ptr<Particle>& p: *dem->particles){
+			if(!p || !p->shape || !p->shape->isA<Sphere>()) continue;
+			minR=min(p->shape->cast<Sphere>().radius,minR);
+		}
+		verletDist=isinf(minR)?0:abs(verletDist)*minR;
+	}
+
+	// with verletDist, only bounds which are not valid anymore are recomputed
+	size_t nDirty=boundDispatcher->updateBounds(*dem,verletDist,/*lazy*/verletDist>0,noBoundOk,/*parallel*/nFullRuns>0);
+	const long nPar=dem->particles->size();
+	bool fullRun=(nDirty>0 || dem->contacts->dirty || (long)boxes.size()!=nPar || grids.empty());
+	dem->contacts->dirty=false;
+	if(!fullRun){
+		// bounds did not change, so neither did their overlaps
+		dem->contacts->removePending(*this,scene);
+		return;
+	}
+
+	/*** FULL COLLIDER RUN ***/
+	nFullRuns++;
+	// contacts not seen in this step will be deleted by ContactLoop
+	dem->contacts->stepColliderLastRun=scene->step;
+
+	boxes.resize(nPar); parLevel.assign(nPar,-1);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long id=0; id<nPar; id++){
+		const shared_ptr<Particle>& p((*dem->particles)[id]);
+		if(!p || !p->shape || !p->shape->bound) continue;
+		boxes[id]=AlignedBox3r(p->shape->bound->min,p->shape->bound->max);
+		parLevel[id]=0;
+	}
+	setupLevels();
+
+	// assign levels, fill grids
+	huge.clear();
+	levelCount.assign(nLevels+1,0);
+	for(long id=0; id<nPar; id++){
+		if(parLevel[id]<0) continue;
+		const AlignedBox3r& b(boxes[id]);
+		const Real sz=b.sizes().maxCoeff();
+		int l=0;
+		if(grids.empty() || !b.min().allFinite() || !b.max().allFinite()) l=nLevels;
+		else while(l<nLevels && sz>grids[l]->cellSize[0]) l++;
+		parLevel[id]=l;
+		levelCount[l]++;
+		if(l==nLevels){ huge.push_back(id); continue; }
+		grids[l]->append(clampedCell(*grids[l],b.min()),id);
+	}
+
+	#ifdef WOO_OPENMP
+		if((int)thNewContacts.size()!=omp_get_max_threads()) thNewContacts.resize(omp_get_max_threads());
+		#pragma omp parallel for schedule(dynamic,256)
+	#else
+		thNewContacts.resize(1);
+	#endif
+	for(long id=0; id<nPar; id++){
+		const int l=parLevel[id];
+		if(l<0) continue;
+		// huge particles against all others; pairs of two huge ones from the higher id
+		for(const Particle::id_t& h: huge){
+			if(h==id || (l==nLevels && h>id)) continue;
+			tryContact(id,h);
+		}
+		if(l==nLevels) continue;
+		const AlignedBox3r& b(boxes[id]);
+		// the same level: 27 neighbour cells, each pair from the lower id
+		const GridStore& g(*grids[l]);
+		const Vector3i c=clampedCell(g,b.min());
+		for(Vector3i ijk=(c-Vector3i::Ones()).cwiseMax(Vector3i::Zero()); ijk[0]<=min(c[0]+1,g.gridSize[0]-1); ijk[0]++){
+			for(ijk[1]=max(c[1]-1,0); ijk[1]<=min(c[1]+1,g.gridSize[1]-1); ijk[1]++){
+				for(ijk[2]=max(c[2]-1,0); ijk[2]<=min(c[2]+1,g.gridSize[2]-1); ijk[2]++){
+					const int sz=g.size(ijk);
+					for(int i=0; i<sz; i++){
+						const Particle::id_t& id2=g.get(ijk,i);
+						if(id2>id) tryContact(id,id2);
+					}
+				}
+			}
+		}
+		// coarser levels: particles with bound minimum between (our minimum - cell size) and our maximum
+		for(int L=l+1; L<nLevels; L++){
+			const GridStore& G(*grids[L]);
+			const Vector3i lo=clampedCell(G,b.min()-G.cellSize), hi=clampedCell(G,b.max());
+			for(Vector3i ijk=lo; ijk[0]<=hi[0]; ijk[0]++){
+				for(ijk[1]=lo[1]; ijk[1]<=hi[1]; ijk[1]++){
+					for(ijk[2]=lo[2]; ijk[2]<=hi[2]; ijk[2]++){
+						const int sz=G.size(ijk);
+						for(int i=0; i<sz; i++) tryContact(id,G.get(ijk,i));
+					}
+				}
+			}
+		}
+	}
+	addNewContacts();
+
+	// pending contacts of which bounds don't overlap anymore
+	dem->contacts->removePending(*this,scene);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include<woo/pkg/dem/Collision.hpp>
+#include<woo/pkg/dem/GridStore.hpp>
+
+/*
+Collider using several GridStore levels with cell sizes in geometric progression.
+
+Every particle is stored only once, in the cell of its Aabb minimum, at the finest level
+where its Aabb fits into one cell. Overlapping particles at the same level are then in
+neighbouring cells (27-stencil); a particle at a finer level may overlap only particles
+from coarser levels stored in cells around its Aabb (at most 3×3×3 cells at each level),
+hence cross-level pairs are only searched from the finer side. Particles with infinite
+Aabb (walls) or larger than the coarsest cell are tested against all other particles.
+
+The domain grows when particles leave it (domainGrow); otherwise, coordinates outside the
+domain are clamped to the boundary cells, which keeps the search complete (only slower).
+*/
+struct HierGridCollider: public Collider{
+	WOO_DECL_LOGGER;
+	bool acceptsField(Field* f) WOO_CXX11_OVERRIDE { return dynamic_cast<DemField*>(f); }
+	void run() WOO_CXX11_OVERRIDE;
+	void pyHandleCustomCtorArgs(py::tuple& t, py::dict& d) WOO_CXX11_OVERRIDE;
+	void getLabeledObjects(const shared_ptr<LabelMapper>&) WOO_CXX11_OVERRIDE;
+	void invalidatePersistentData() WOO_CXX11_OVERRIDE { grids.clear(); boxes.clear(); }
+	// predicate called from ContactContainer::removePending
+	bool shouldBeRemoved(const shared_ptr<Contact>& C, Scene* scene) const;
+
+	private:
+	DemField* dem;
+	// bounds of all particles, copied from Aabb at every full run
+	vector<AlignedBox3r> boxes;
+	// level for every particle; -1 for particles without bound, nLevels for huge particles
+	vector<int> parLevel;
+	vector<Particle::id_t> huge;
+	int nLevels;
+	// new contacts found by each thread
+	vector<vector<shared_ptr<Contact>>> thNewContacts;
+	bool boxesOverlap(const Particle::id_t& a, const Particle::id_t& b) const {
+		const AlignedBox3r& A(boxes[a]); const AlignedBox3r& B(boxes[b]);
+		return (A.min().array()<=B.max().array()).all() && (A.max().array()>=B.min().array()).all();
+	}
+	// cell of given point at given level, clamped to the grid
+	Vector3i clampedCell(const GridStore& g, const Vector3r& x) const;
+	// set up levels and grids based on current bounds
+	void setupLevels();
+	// check pair with overlapping bounds, mark existing contact as seen or queue a new one
+	void tryContact(const Particle::id_t& a, const Particle::id_t& b);
+	// add contacts queued in thNewContacts
+	void addNewContacts();
+
+	public:
+	#define woo_dem_HierGridCollider__CLASS_BASE_DOC_ATTRS_CTOR \
+		HierGridCollider,Collider,ClassTrait().doc("Collider using hierarchical (multi-level) grid, suitable for particles with wide size distribution; particles are assigned to the level matching the size of their :obj:`Aabb`, and only cross-level pairs where bounds may overlap are tested. Bounds are computed by :obj:`boundDispatcher` (the same functors as for :obj:`InsertionSortCollider`) and enlarged by :obj:`verletDist`, so that the collider only runs when some bound became invalid. Contacts not encountered in the last full run are deleted by :obj:`ContactLoop` (via :obj:`ContactContainer.stepColliderLastRun`). Periodic boundaries are not supported.").section("","",{"GridStore"}), \
+		((AlignedBox3r,domain,AlignedBox3r(),,"Domain spanned by the grids. Determined from finite particle bounds at the first run if empty, and enlarged at full runs when particles leave it (see :obj:`domainGrow`).")) \
+		((Real,domainGrow,.1,,"When finite bounds extend beyond :obj:`domain` at a full run, the domain is enlarged to contain them, plus this fraction of its size on each side (so that steadily spreading particles don't cause grids to be rebuilt at every full run). If negative, the domain is never changed and particles outside are stored in boundary cells, which is correct, but slow if there are many of them.")) \
+		((Real,minCellSize,NaN,AttrTrait<>().lenUnit(),"Cell size of the finest level; if not positive, the smallest bound size is used.")) \
+		((Real,levelRatio,4.,,"Ratio of cell sizes of subsequent levels.")) \
+		((int,maxLevels,8,,"Maximum number of levels; particles larger than the coarsest cell are tested against all other particles.")) \
+		((long,maxCells,1<<21,,"Maximum number of cells in one level; the finest cell size is increased if needed.")) \
+		((Real,verletDist,((void)"Automatically initialized",-.05),AttrTrait<>().lenUnit(),"Length by which to enlarge particle bounds, to avoid running collider at every step. Negative value will trigger automatic computation, so that the real value will be ``|verletDist|`` × minimum spherical particle radius; if there are no spherical particles, it will be disabled.")) \
+		((bool,noBoundOk,false,,"Allow particles without bounding box.")) \
+		((int,gridDense,4,,"Length of dense storage of :obj:`GridStore` cells.")) \
+		((int,exIniSize,4,,":obj:`GridStore.exIniSize` for new grids.")) \
+		((int,exNumMaps,100,,":obj:`GridStore.exNumMaps` for new grids.")) \
+		((int,paraAddMin,1000,,"Minimum number of new contacts to add them in parallel (concurrent mode of :obj:`ContactContainer`; not with :obj:`Scene.deterministic`).")) \
+		((shared_ptr<BoundDispatcher>,boundDispatcher,make_shared<BoundDispatcher>(),AttrTrait<Attr::readonly>(),":obj:`BoundDispatcher` object that is used for creating :obj:`bounds <Particle.bound>` on collider's request as necessary.")) \
+		((vector<shared_ptr<GridStore>>,grids,,AttrTrait<Attr::readonly|Attr::noSave>(),"Grids of all levels, from the finest to the coarsest.")) \
+		((vector<int>,levelCount,,AttrTrait<Attr::readonly|Attr::noSave>(),"Number of particles at each level in the last full run; the last item is the number of particles tested against all others.")) \
+		((int,nFullRuns,0,,"Number of full runs, when collision detection is needed; only informative.")) \
+		, /*ctor*/ nLevels=0;
+
+	WOO_DECL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_HierGridCollider__CLASS_BASE_DOC_ATTRS_CTOR);
+};
+WOO_REGISTER_OBJECT(HierGridCollider);
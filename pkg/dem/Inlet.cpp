@@ -225,7 +225,11 @@ void RandomInlet::run(){
 		for(const auto& e: scene->engines){ collider=dynamic_pointer_cast<Collider>(e); if(collider) break; }
 		if(!collider) throw std::runtime_error("RandomInlet: no Collider found within engines (needed for collisions detection with already existing particles; if you don't need that, set collideExisting=False.)");
 		}
-		if(dynamic_pointer_cast<InsertionSortCollider>(collider)) static_pointer_cast<InsertionSortCollider>(collider)->forceInitSort=true;
+		// new particles are merged into the collider without full sort, unless it can't do that
+		if(dynamic_pointer_cast<InsertionSortCollider>(collider)){
+			InsertionSortCollider& isc(collider->cast<InsertionSortCollider>());
+			if(!isc.incInsert || scene->isPeriodic) isc.forceInitSort=true;
+		}
 	}
 	if(isnan(massRate)) throw std::runtime_error("RandomInlet.massRate must be given (is "+to_string(massRate)+"); if you want to generate as many particles as possible, say massRate=0.");
 	if(massRate<=0 && maxAttempts==0) throw std::runtime_error("RandomInlet.massFlowRate<=0 (no massFlowRate prescribed), but RandomInlet.maxAttempts==0. (unlimited number of attempts); this would cause infinite loop.");
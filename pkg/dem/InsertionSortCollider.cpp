@@ -8,6 +8,9 @@
 #include<algorithm>
 #include<vector>
 #include<boost/static_assert.hpp>
+#include<cstdint>
+#include<cstring>
+#include<type_traits>
 
 #if defined(WOO_OPENMP) && defined(__GNUC__)
 	#include<parallel/algorithm>
@@ -25,6 +28,36 @@ void InsertionSortCollider::makeRemoveContactLater_process() {
 
 	ISC_CHECKPOINT("later: start");
 
+	#ifdef WOO_OPENMP
+		size_t nRemove=0, nMake=0;
+		for(const auto& rr: rremoveContacts) nRemove+=rr.size();
+		for(const auto& mm: mmakeContacts) nMake+=mm.size();
+		if(paraLater && !scene->deterministic && nRemove+nMake>=(size_t)paraLaterMin){
+			ContactContainer& cc(*dem->contacts);
+			cc.beginConcurrent(nMake);
+			// removals must be finished before additions, since the same pair may be in both
+			for(auto* later: {&rremoveContacts,&mmakeContacts}){
+				const bool isRemove=(later==&rremoveContacts);
+				#pragma omp parallel
+				{
+					// each thread processes its share of every per-thread vector
+					for(const auto& CC: *later){
+						const long sz=CC.size();
+						#pragma omp for schedule(static) nowait
+						for(long i=0; i<sz; i++){
+							if(isRemove) cc.removeConcurrent(CC[i]);
+							else cc.addConcurrent(CC[i]);
+						}
+					}
+				}
+				for(auto& CC: *later) CC.clear();
+			}
+			cc.endConcurrent();
+			ISC_CHECKPOINT("later: parallel");
+			return;
+		}
+	#endif
+
 
 	#ifdef WOO_OPENMP
 		for(auto& removeContacts: rremoveContacts){
@@ -97,26 +130,69 @@ void InsertionSortCollider::handleBoundInversion(Particle::id_t id1, Particle::i
 	assert(false); // unreachable
 }
 
+#ifdef WOO_OPENMP
+size_t InsertionSortCollider::sortChunkCount(long n){
+	// will be adapted -- can be the double and so on
+	int chunks_per_core=ompTuneSort[0];
+	int min_per_core=2*ompTuneSort[1]; // ×2: number of particles → number of bounds;
+	int max_per_core=2*ompTuneSort[2];
+	int TH=omp_get_max_threads();
+	size_t chunks=TH*max(1,chunks_per_core);
+	// apply bounds, but always round up to a multiple of TH
+	if(min_per_core>0 && (int)(n/chunks)<min_per_core) chunks=TH*(int)ceil(max(1L,n/min_per_core)*1./TH);
+	else if(max_per_core>0 && (int)(n/chunks)>max_per_core) chunks=TH*(int)ceil(max(1L,n/max_per_core)*1./TH);
+	if(chunks==0) throw std::logic_error("0 chunks for parallel insertion sort!");
+	return chunks;
+}
+#endif
+
+void InsertionSortCollider::sortTimingUpdate(TimingInfo::delta nsec, long nPar){
+	tuneNsec+=nsec; tunePasses+=sortPasses.sum(); tuneSteps++;
+	if(tuneSteps<max(1,ompTuneWindow)) return;
+	const Real t=tuneNsec*1e-9/tuneSteps;
+	sortPassTime=tuneNsec*1e-9/tunePasses;
+	tuneSteps=tunePasses=0; tuneNsec=0;
+	#ifdef WOO_OPENMP
+		// don't override what the user set
+		if(!ompTuneAuto || ompTuneSort!=tuneSet){ tuneCand=-1; return; }
+		const int TH=omp_get_max_threads();
+		if(tuneCand<0){
+			// tuned already, for about the same number of particles
+			if(nPar<=2*tuneNPar && 2*nPar>=tuneNPar) return;
+			// (re)start tuning; the window just finished was measured with the previous settings
+			tuneCand=0; tuneBest=Inf; tuneNPar=nPar;
+			ompTuneTimings.clear();
+			ompTuneSort=tuneSet=Vector3i(1,0,0);
+			return;
+		}
+		const int cpc=ompTuneSort[0];
+		ompTuneTimings.push_back(Vector3r(cpc,t,sortPassTime));
+		if(t<tuneBest){ tuneBest=t; tuneBestCpc=cpc; }
+		// try twice as many chunks, unless slower than the best so far, or chunks would be too small for the parallel sort (see insertionSort)
+		if(t<=tuneBest && 2*nPar/(TH*2*cpc)>=100){
+			tuneCand++;
+			ompTuneSort=tuneSet=Vector3i(2*cpc,0,0);
+			return;
+		}
+		// bound particles per chunk around the tuned value, so that the number of chunks follows the number of particles
+		const long chunkPar=nPar/(TH*tuneBestCpc);
+		ompTuneSort=tuneSet=Vector3i(tuneBestCpc,chunkPar/2,2*chunkPar);
+		tuneCand=-1;
+		LOG_INFO("Tuned ompTuneSort="<<ompTuneSort.transpose()<<" ("<<ompTuneTimings.size()<<" candidates, "<<tuneBest*1e3<<" ms per sort).");
+	#endif
+}
+
 void InsertionSortCollider::insertionSort(VecBounds& v, bool doCollide, int ax){
 	assert(!periodic);
 	assert(v.size==(long)v.vec.size());
+	sortPasses[ax]=1;
 	#ifndef WOO_OPENMP
 		insertionSort_part(v,doCollide,ax,0,v.size,0);
 	#else
-
-		// will be adapted -- can be the double and so on
-		int chunks_per_core=ompTuneSort[0];
-		int min_per_core=2*ompTuneSort[1]; // ×2: number of particles → number of bounds;
-		int max_per_core=2*ompTuneSort[2];
-		int TH=omp_get_max_threads();
-		size_t chunks=TH*max(1,chunks_per_core);
-		// apply bounds, but always round up to a multiple of TH
-		if(min_per_core>0 && (int)(v.size/chunks)<min_per_core) chunks=TH*(int)ceil(max(1L,v.size/min_per_core)*1./TH);
-		else if(max_per_core>0 && (int)(v.size/chunks)>max_per_core) chunks=TH*(int)ceil(max(1L,v.size/max_per_core)*1./TH);
+		size_t chunks=sortChunkCount(v.size);
 		size_t chunkSize=v.size/chunks;
 		// don't bother with parallelized sorting for small number of bounds
 		if(chunks==1){ insertionSort_part(v,doCollide,ax,0,v.size,0); return; }
-		if(chunks==0) throw std::logic_error("0 chunks for parallel insertion sort!");
 		sortChunks=chunks; // for diagnostics
 
 		// too small chunks, go sequential
@@ -153,6 +229,7 @@ void InsertionSortCollider::insertionSort(VecBounds& v, bool doCollide, int ax){
 				if(v[s[chunk]-1]>v[s[chunk]]){ isOk=false; break; }
 			}
 		}
+		sortPasses[ax]=pass;
 		// cerr<<"Parallel insertion sort done ("<<pass+1<<") passes, "<<chunks<<" chunks; inversions remaining: "<<countInversions().transpose()<<endl;
 		// cerr<<"Parallel insertion sort done, needed "<<pass+1<<" passes."<<endl;
 	#endif
@@ -297,67 +374,6 @@ bool InsertionSortCollider::updateBboxes_doFullRun(){
 		verletDist=isinf(minR) ? 0 : abs(verletDist)*minR;
 	}
 
-	bool recomputeBounds=false;
-	if(verletDist==0){
-		recomputeBounds=true;
-	} else {
-		// first loop only checks if there something is our
-		for(const shared_ptr<Particle>& p: *dem->particles){
-			if(!p->shape) continue;
-			const int nNodes=p->shape->nodes.size();
-			// below we throw exception for particle that has no functor afer the dispatcher has been called
-			// that would prevent mistakenly boundless particless triggering collisions every time
-			if(!p->shape->bound){
-				LOG_TRACE("recomputeBounds because of #"<<p->id<<" without bound");
-				recomputeBounds=true;
-				break;
-			}
-			// existing bound, do we need to update it?
-			const Aabb& aabb=p->shape->bound->cast<Aabb>();
-			assert(aabb.nodeLastPos.size()==p->shape->nodes.size());
-			if(isnan(aabb.min.maxCoeff())||isnan(aabb.max.maxCoeff())) { recomputeBounds=true; break; } 
-			// check rotation difference, for particles where it matters
-			Real moveDueToRot2=0.;
-			if(aabb.maxRot>=0.){
-				assert(!isnan(aabb.maxRot));
-				Real maxRot=0.;
-				for(int i=0; i<nNodes; i++){
-					AngleAxisr aa(aabb.nodeLastOri[i].conjugate()*p->shape->nodes[i]->ori);
-					// moving will decrease the angle, it is taken in account here, with the asymptote
-					// it is perhaps not totally correct... :|
-					maxRot=max(maxRot,abs(aa.angle())); // abs perhaps not needed?
-					//cerr<<"#"<<p->id<<": rot="<<aa.angle()<<" (max "<<aabb.maxRot<<")"<<endl;
-				}
-				if(maxRot>aabb.maxRot){
-					LOG_TRACE("recomputeBounds because of #"<<p->id<<" rotating too much");
-					recomputeBounds=true;
-					break;
-				}
-				// linearize here, but don't subtract verletDist
-				moveDueToRot2=pow(.5*(aabb.max-aabb.min).maxCoeff()*maxRot,2);
-			}
-			// check movement
-			Real d2=0; 
-			for(int i=0; i<nNodes; i++){
-				d2=max(d2,(aabb.nodeLastPos[i]-p->shape->nodes[i]->pos).squaredNorm());
-				//cerr<<"#"<<p->id<<": move2="<<d2<<" (+"<<moveDueToRot2<<"; max "<<aabb.maxD2<<")"<<endl;
-				// maxVel2b=max(maxVel2b,p->shape->nodes[i]->getData<DemData>().vel.squaredNorm());
-			}
-			if(d2+moveDueToRot2>aabb.maxD2){
-				LOG_TRACE("recomputeBounds because of #"<<p->id<<" moved too far");
-				recomputeBounds=true;
-				break;
-			}
-			// fine, particle doesn't need to be updated
-		}
-	}
-	ISC_CHECKPOINT("bounds: check");
-	// bounds don't need update, collision neither
-	if(!recomputeBounds) return false;
-
-
-	// this loop takes 25% collider time when not parallelized, give it a try
-	size_t size=particles->size();
 	/*
 		HACK: there are some (reproducible) crashes in the ctor of Aabb when this is run in parallel
 		for the first time. This is not caused by calls to createIndex() in Aabb or Bound ctors
@@ -370,50 +386,11 @@ bool InsertionSortCollider::updateBboxes_doFullRun(){
 
 		Therefore, always run serially for the very first time, until a better solution is found.
 	*/
-	#ifdef WOO_OPENMP
-		#pragma omp parallel for num_threads(nFullRuns>0?omp_get_max_threads():1)
-	#endif
-	for(size_t i=0; i<size; i++){
-		const shared_ptr<Particle>& p((*particles)[i]);
-		if(!p || !p->shape) continue;
-		// call dispatcher now
-		// cerr<<"["<<p->id<<"]";
-		boundDispatcher->operator()(p->shape);
-		if(!p->shape->bound){
-			if(noBoundOk) continue;
-			throw std::runtime_error("InsertionSortCollider: No bound was created for #"+lexical_cast<string>(p->id)+", provide a Bo1_*_Aabb functor for it. (Particle without Aabb are not supported yet, and perhaps will never be (what is such a particle good for?!)");
-		}
-		Aabb& aabb=p->shape->bound->cast<Aabb>();
-		const int nNodes=p->shape->nodes.size();
-		// save reference node positions
-		aabb.nodeLastPos.resize(nNodes);
-		aabb.nodeLastOri.resize(nNodes);
-		for(int i=0; i<nNodes; i++){
-			aabb.nodeLastPos[i]=p->shape->nodes[i]->pos;
-			aabb.nodeLastOri[i]=p->shape->nodes[i]->ori;
-		}
-		aabb.maxD2=pow(verletDist,2);
-		if(isnan(aabb.maxRot)) throw std::runtime_error("S.dem.par["+to_string(p->id)+"]: bound functor did not set maxRot -- should be set to either to a negative value (to ignore it) or to non-negative value (maxRot will be set from verletDist in that case); this is an implementation error.");
-		#if 0
-			// proportionally to relVel, shift bbox margin in the direction of velocity
-			// take velocity of nodes[0] as representative
-			const Vector3r& v0=p->shape->nodes[0]->getData<DemData>().vel;
-			Real vNorm=v0.norm();
-			Real relVel=max(maxVel2b,maxVel2)==0?0:vNorm/sqrt(max(maxVel2b,maxVel2));
-		#endif
-		if(verletDist>0){
-			if(aabb.maxRot>=0){
-				// maximum rotation arm, assume centroid in the middle
-				Real maxArm=.5*(aabb.max-aabb.min).maxCoeff();
-				if(maxArm>0.) aabb.maxRot=atan(verletDist/maxArm); // FIXME: this may be very slow...?
-				else aabb.maxRot=0.;
-			}
-			aabb.max+=verletDist*Vector3r::Ones();
-			aabb.min-=verletDist*Vector3r::Ones();
-		}
-	}
+	// with verletDist, only bounds which are not valid anymore are recomputed; ids are in boundDispatcher->dirty
+	// without verletDist, all bounds are updated every time
+	size_t nDirty=boundDispatcher->updateBounds(*dem,verletDist,/*lazy*/verletDist>0,noBoundOk,/*parallel*/nFullRuns>0);
 	ISC_CHECKPOINT("bounds: recompute");
-	return true;
+	return nDirty>0;
 }
 
 bool InsertionSortCollider::prologue_doFullRun(){
@@ -451,6 +428,8 @@ void InsertionSortCollider::run(){
 	ISC_CHECKPOINT("prologue");
 	bool runBboxes=updateBboxes_doFullRun();
 	ISC_CHECKPOINT("bbox-check");
+	// only some bounds were updated, and bound arrays are otherwise up-to-date: copy just those
+	const bool onlyDirty=(!fullRun && runBboxes);
 
 	if(runBboxes) fullRun=true;
 
@@ -472,14 +451,26 @@ void InsertionSortCollider::run(){
 		bool doInitSort=false;
 		if(forceInitSort){ doInitSort=true; forceInitSort=false; }
 		assert(BB[0].size==BB[1].size); assert(BB[1].size==BB[2].size);
+		// new particles are inserted into the sorted arrays by merging, see insertNewBounds
+		const bool incremental=(incInsert && !periodic && !doInitSort && !sortThenCollide && BB[0].size>0 && (long)BB[0].vec.size()==BB[0].size);
+		// particles with higher ids were added since the last run
+		const long nParPrev=BB[0].size/2;
 		if(BB[0].size!=2*nPar){
-			LOG_DEBUG("Resize bounds containers from "<<BB[0].size<<" to "<<nPar*2<<", will std::sort.");
-			// bodies deleted; clear the container completely, and do as if all bodies were added (rather slow…)
-			// future possibility: insertion sort with such operator that deleted bodies would all go to the end, then just trim bounds
-			if(2*nPar<BB[0].size){ for(int i: {0,1,2}){ BB[i].vec.clear(); BB[i].size=0; }}
+			LOG_DEBUG("Resize bounds containers from "<<BB[0].size<<" to "<<nPar*2<<(incremental?", incremental.":", will std::sort."));
+			if(2*nPar<BB[0].size){
+				// particles at the end of the container were deleted: remove their bounds, which keeps the remaining ones sorted
+				if(incremental){
+					for(int i: {0,1,2}){
+						BB[i].vec.erase(std::remove_if(BB[i].vec.begin(),BB[i].vec.end(),[&nPar](const Bounds& b){ return b.id>=nPar; }),BB[i].vec.end());
+						BB[i].size=BB[i].vec.size();
+					}
+				}
+				// clear the container completely, and do as if all bodies were added (rather slow…)
+				else { for(int i: {0,1,2}){ BB[i].vec.clear(); BB[i].size=0; } doInitSort=true; }
+			}
 			// more than 100 bodies was added, do initial sort again
 			// maybe: should rather depend on ratio of added bodies to those already present...?
-			else if(2*nPar-BB[0].size>200 || BB[0].size==0) doInitSort=true;
+			else if(!incremental && (2*nPar-BB[0].size>200 || BB[0].size==0)) doInitSort=true;
 			assert((BB[0].size%2)==0);
 			for(int i:{0,1,2}){
 				BB[i].vec.reserve(2*nPar);
@@ -508,58 +499,85 @@ void InsertionSortCollider::run(){
 
 	ISC_CHECKPOINT("bound");
 
-	// copy bounds along given axis into our arrays
-	// this loop takes 27% of total collider time, try to make it parallel
-		#ifdef WOO_OPENMP
-			#pragma omp parallel for schedule(static)
-		#endif
-		for(long i=0; i<2*nPar; i++){
-			for(int j=0; j<3; j++){
-				VecBounds& BBj=BB[j];
-				const Particle::id_t id=BBj[i].id;
-				const shared_ptr<Particle>& b=(*particles)[id];
-				if(likely(b)){
-					const shared_ptr<Bound>& bv=b->shape->bound;
-					// coordinate is min/max if has bounding volume, otherwise both are the position. Add periodic shift so that we are inside the cell
-					// watch out for the parentheses around ?: within ?: (there was unwanted conversion of the Reals to bools!)
-					BBj[i].coord=((BBj[i].flags.hasBB=((bool)bv)) ? (BBj[i].flags.isMin ? bv->min[j] : bv->max[j]) : (b->shape->nodes[0]->pos[j])) - (periodic ? BBj.cellDim*BBj[i].period : 0.);
-					BBj[i].flags.isInf=false;
-					if(periodic && isinf(BBj[i].coord)){
-						// check that min and max are both infinite or none of them
-						assert(!bv || ((isinf(bv->min[j]) && isinf(bv->max[j])) || (!isinf(bv->min[j]) && !isinf(bv->max[j]))));
-						// infinite particles span between cell boundaries (both have coordinate 0), the lower bound having period 0, the upper one 1 (does not change during simulation at all)
-						BBj[i].period=(BBj[i].flags.isMin?0:1); BBj[i].coord=0.; /* wasInf=true; */
-						BBj[i].flags.isInf=true; // keep track of infinite coord here, so that we know there is no separation possible later
-					}
-				} else { // vanished particle
-					BBj[i].flags.hasBB=false;
-					// when doing initial sort, set to -inf so that nonexistent particles don't generate inversions later
-					// for periodic, use zero, since -Inf would make that particle move through all other every time
-					// slowing the computation down by two orders of magnitude
-					if(doInitSort) BBj[i].coord=(periodic?0:-Inf);
-					// otherwise keep the coordinate as-is, to minimize inversions
-				}
-				// if initializing periodic, shift coords & record the period into BBj[i].period
-				if(doInitSort && periodic) {
-					// don't do this for infinite bbox which was adjusted to the cell size above
-					if(!BBj[i].flags.isInf) BBj[i].coord=cellWrap(BBj[i].coord,0,BBj.cellDim,BBj[i].period);
-				}
-			}	
-		}
-	ISC_CHECKPOINT("copy-bounds");
+	// mark particles with updated bounds; the others need not be copied (periodic coordinates are always copied, as the cell might have changed)
+	const bool copyDirty=(onlyDirty && !doInitSort && !periodic);
+	if(copyDirty){
+		dirtyMask.assign(nPar,0);
+		for(const int& id: boundDispatcher->dirty) dirtyMask[id]=1;
+	}
 
-	// for each body, copy its minima and maxima, for quick checks of overlaps later
+	// for each particle, copy its minima and maxima (for quick checks of overlaps later), and record its state in parState;
+	// this is the only place where particles and their bounds are dereferenced, the copy below reads flat arrays only
+	// particles which did not exist in the previous run (appended, or re-using ids of removed ones) are marked in isNew
+	if(parState.size()!=(size_t)nPar) parState.resize(nPar,0);
+	if(incremental) isNew.assign(nPar,0);
+	long nNew=0;
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static) reduction(+:nNew)
+	#endif
 	for(Particle::id_t id=0; id<nPar; id++){
 		BOOST_STATIC_ASSERT(sizeof(Vector3r)==3*sizeof(Real));
 		const shared_ptr<Particle>& b=(*particles)[id];
-		if(likely(b)){
-			const shared_ptr<Bound>& bv=b->shape->bound;
-			if(likely(bv)) { memcpy(&minima[3*id],&bv->min,3*sizeof(Real)); memcpy(&maxima[3*id],&bv->max,3*sizeof(Real)); } // ⇐ faster than 6 assignments 
-			else{ const Vector3r& pos=b->shape->nodes[0]->pos; memcpy(&minima[3*id],&pos,3*sizeof(Real)); memcpy(&maxima[3*id],&pos,3*sizeof(Real)); }
-		} else { memset(&minima[3*id],0,3*sizeof(Real)); memset(&maxima[3*id],0,3*sizeof(Real)); }
+		if(incremental && (id>=nParPrev || (likely(b) && !(parState[id]&PAR_EXISTS)))){ isNew[id]=1; nNew++; }
+		if(unlikely(!b)){
+			memset(&minima[3*id],0,3*sizeof(Real)); memset(&maxima[3*id],0,3*sizeof(Real));
+			parState[id]=PAR_COPY;
+			continue;
+		}
+		// bounds not updated, parState from the previous step is still valid
+		if(copyDirty && !dirtyMask[id]){ parState[id]&=~PAR_COPY; continue; }
+		const shared_ptr<Bound>& bv=b->shape->bound;
+		if(likely(bv)){ memcpy(&minima[3*id],&bv->min,3*sizeof(Real)); memcpy(&maxima[3*id],&bv->max,3*sizeof(Real)); parState[id]=PAR_EXISTS|PAR_HASBB|PAR_COPY; } // ⇐ faster than 6 assignments
+		else{ const Vector3r& pos=b->shape->nodes[0]->pos; memcpy(&minima[3*id],&pos,3*sizeof(Real)); memcpy(&maxima[3*id],&pos,3*sizeof(Real)); parState[id]=PAR_EXISTS|PAR_COPY; }
 	}
 	ISC_CHECKPOINT("copy-minima-maxima");
 
+	// copy bounds into our arrays, axis by axis, so that each thread streams through a contiguous part of one array
+	// coordinate is min/max if has bounding volume, otherwise both are the position (minima and maxima hold that already)
+	#ifdef WOO_OPENMP
+		#pragma omp parallel
+	#endif
+	for(int j=0; j<3; j++){
+		VecBounds& BBj=BB[j];
+		const Real* const mins=minima.data()+j; const Real* const maxs=maxima.data()+j;
+		const unsigned char* const state=parState.data();
+		const Real cellDim=(periodic?BBj.cellDim:0.);
+		#ifdef WOO_OPENMP
+			#pragma omp for schedule(static)
+		#endif
+		for(long i=0; i<2*nPar; i++){
+			Bounds& B=BBj.vec[i];
+			const Particle::id_t id=B.id;
+			const unsigned char st=state[id];
+			if(!(st&PAR_COPY)) continue;
+			if(likely(st&PAR_EXISTS)){
+				const Real c=(B.flags.isMin?mins[3*id]:maxs[3*id]);
+				B.flags.hasBB=((st&PAR_HASBB)?1:0);
+				// add periodic shift so that we are inside the cell
+				B.coord=c-cellDim*B.period;
+				B.flags.isInf=false;
+				if(periodic && isinf(B.coord)){
+					// check that min and max are both infinite or none of them
+					assert(isinf(mins[3*id])==isinf(maxs[3*id]));
+					// infinite particles span between cell boundaries (both have coordinate 0), the lower bound having period 0, the upper one 1 (does not change during simulation at all)
+					B.period=(B.flags.isMin?0:1); B.coord=0.;
+					B.flags.isInf=true; // keep track of infinite coord here, so that we know there is no separation possible later
+				}
+			} else { // vanished particle
+				B.flags.hasBB=false;
+				// when doing initial sort, set to -inf so that nonexistent particles don't generate inversions later
+				// for periodic, use zero, since -Inf would make that particle move through all other every time
+				// slowing the computation down by two orders of magnitude
+				if(doInitSort) B.coord=(periodic?0:-Inf);
+				// otherwise keep the coordinate as-is, to minimize inversions
+			}
+			// if initializing periodic, shift coords & record the period into B.period
+			// don't do this for infinite bbox which was adjusted to the cell size above
+			if(doInitSort && periodic && !B.flags.isInf) B.coord=cellWrap(B.coord,0,BBj.cellDim,B.period);
+		}
+	}
+	ISC_CHECKPOINT("copy-bounds");
+
 	// process interactions that the constitutive law asked to be erased
 	field->cast<DemField>().contacts->removePending(*this,scene);
 
@@ -570,12 +588,17 @@ void InsertionSortCollider::run(){
 		// the regular case
 		if(!doInitSort && !sortThenCollide){
 			/* each inversion in insertionSort calls handleBoundInversion, which in turns may add/remove interaction */
-			if(!periodic) for(int i:{0,1,2}){
-				//Vector3i invs=countInversions();
-				insertionSort(BB[i],/*collide*/true,i); 
-				//LOG_INFO(invs.sum()<<"/"<<stepInvs<<" invs (counted/insertion sort)");
+			if(!periodic && nNew>0) insertNewBounds(nPar);
+			else {
+				const TimingInfo::delta t0=TimingInfo::getNow(/*evenIfDisabled*/true);
+				if(!periodic) for(int i:{0,1,2}){
+					//Vector3i invs=countInversions();
+					insertionSort(BB[i],/*collide*/true,i); 
+					//LOG_INFO(invs.sum()<<"/"<<stepInvs<<" invs (counted/insertion sort)");
+				}
+				else for(int i:{0,1,2}) insertionSortPeri(BB[i],/*collide*/true,i);
+				sortTimingUpdate(TimingInfo::getNow(/*evenIfDisabled*/true)-t0,nPar);
 			}
-			else for(int i:{0,1,2}) insertionSortPeri(BB[i],/*collide*/true,i);
 			ISC_CHECKPOINT("insertion-sort-done");
 		}
 		// create initial interactions (much slower)
@@ -586,11 +609,14 @@ void InsertionSortCollider::run(){
 				LOG_DEBUG("Initial std::sort over all axes");
 				for(int i:{0,1,2}) {
 					BB[i].loIdx=0;
-					#if defined(WOO_OPENMP) && defined(__GNUC__) && /*this one crashes here, why..? */ !defined(__INTEL_COMPILER) 
-						__gnu_parallel::sort(BB[i].vec.begin(),BB[i].vec.end());
-					#else
-						std::sort(BB[i].vec.begin(),BB[i].vec.end());
-					#endif
+					if(radixSort && std::is_same<Real,double>::value) radixSortBounds(BB[i]);
+					else {
+						#if defined(WOO_OPENMP) && defined(__GNUC__) && /*this one crashes here, why..? */ !defined(__INTEL_COMPILER) 
+							__gnu_parallel::sort(BB[i].vec.begin(),BB[i].vec.end());
+						#else
+							std::sort(BB[i].vec.begin(),BB[i].vec.end());
+						#endif
+					}
 				}
 				numReinit++;
 			} else { // sortThenCollide
@@ -604,8 +630,14 @@ void InsertionSortCollider::run(){
 			VecBounds& V=BB[sortAxis];
 
 			// go through potential aabb collisions, create contacts as necessary
+			// each lower bound is traversed independently and contacts are only queued (makeContactLater), so the sweep runs in parallel;
+			// upper bounds are skipped right away, hence dynamic scheduling; the order of contacts depends on scheduling, so not with Scene.deterministic
+			const bool paraSweep=(paraInitSweep && !scene->deterministic);
+			string err;
 			if(!periodic){
-				// parallelizing this decreases performance slightly
+				#ifdef WOO_OPENMP
+					#pragma omp parallel for schedule(dynamic,256) num_threads(paraSweep?omp_get_max_threads():1)
+				#endif
 				for(long i=0; i<2*nPar; i++){
 					// start from the lower bound (i.e. skipping upper bounds)
 					// skip bodies without bbox, because they don't collide
@@ -622,20 +654,31 @@ void InsertionSortCollider::run(){
 					}
 				}
 			} else { // periodic case: see comments above
-				// parallelizing this decreases performance slightly
+				#ifdef WOO_OPENMP
+					#pragma omp parallel for schedule(dynamic,256) num_threads(paraSweep?omp_get_max_threads():1)
+				#endif
 				for(long i=0; i<2*nPar; i++){
 					if(unlikely(!(V[i].flags.isMin && V[i].flags.hasBB))) continue;
 					const Particle::id_t& iid=V[i].id;
 					long cnt=0;
-					// we might wrap over the periodic boundary here; that's why the condition is different from the aperiodic case
-					for(long j=V.norm(i+1); V[j].id!=iid; j=V.norm(j+1)){
-						const Particle::id_t& jid=V[j].id;
-						if(!V[j].flags.isMin) continue;
-						handleBoundInversionPeri(iid,jid,/*separating*/false);
-						if(cnt++>2*(long)nPar){ LOG_FATAL("Uninterrupted loop in the initial sort?"); throw std::logic_error("loop??"); }
+					// exceptions must not escape the parallel loop; the first one is re-thrown after it
+					try{
+						// we might wrap over the periodic boundary here; that's why the condition is different from the aperiodic case
+						for(long j=V.norm(i+1); V[j].id!=iid; j=V.norm(j+1)){
+							const Particle::id_t& jid=V[j].id;
+							if(!V[j].flags.isMin) continue;
+							handleBoundInversionPeri(iid,jid,/*separating*/false);
+							if(cnt++>2*(long)nPar){ LOG_FATAL("Uninterrupted loop in the initial sort?"); throw std::logic_error("loop??"); }
+						}
+					} catch(std::exception& e){
+						#ifdef WOO_OPENMP
+							#pragma omp critical(iscInitSweepErr)
+						#endif
+						{ if(err.empty()) err=e.what(); }
 					}
 				}
 			}
+			if(!err.empty()) throw std::runtime_error(err);
 			ISC_CHECKPOINT("init-contacts-done");
 		}
 	ISC_CHECKPOINT("sort&collide");
@@ -646,6 +689,116 @@ void InsertionSortCollider::run(){
 }
 
 
+void InsertionSortCollider::insertNewBounds(long nPar){
+	assert(!periodic);
+	assert((long)isNew.size()==nPar);
+	for(int ax:{0,1,2}){
+		VecBounds& V=BB[ax];
+		// take bounds of new particles out, keeping the order of the others
+		newBounds.clear();
+		for(const Bounds& b: V.vec) if(isNew[b.id]) newBounds.push_back(b);
+		V.vec.erase(std::remove_if(V.vec.begin(),V.vec.end(),[this](const Bounds& b){ return (bool)isNew[b.id]; }),V.vec.end());
+		V.size=V.vec.size();
+		// the usual sort of existing bounds, with inversions handled as they happen
+		insertionSort(V,/*collide*/true,ax);
+		// sort new bounds and merge them in
+		std::sort(newBounds.begin(),newBounds.end());
+		const long mid=V.size;
+		V.vec.insert(V.vec.end(),newBounds.begin(),newBounds.end());
+		std::inplace_merge(V.vec.begin(),V.vec.begin()+mid,V.vec.end());
+		V.size=V.vec.size();
+		assert(V.size==2*nPar);
+	}
+	numIncInsert++;
+	/*
+	Find contacts of new particles with a single sweep along sortAxis, keeping track of open intervals (min passed, max not yet):
+	at the lower bound of a new particle, all open intervals overlap it along the axis; at the lower bound of an existing particle, open intervals of new particles do.
+	Each pair with at least one new particle is checked exactly once; pairs of existing particles were handled by the insertion sort.
+	*/
+	const VecBounds& V=BB[sortAxis];
+	vector<Particle::id_t> openAll, openNew;
+	vector<int> posAll(nPar,-1), posNew(nPar,-1);
+	auto openAdd=[](vector<Particle::id_t>& open, vector<int>& pos, Particle::id_t id){ pos[id]=open.size(); open.push_back(id); };
+	auto openRemove=[](vector<Particle::id_t>& open, vector<int>& pos, Particle::id_t id){
+		if(pos[id]<0) return;
+		const Particle::id_t last=open.back(); open[pos[id]]=last; pos[last]=pos[id]; open.pop_back(); pos[id]=-1;
+	};
+	for(long i=0; i<V.size; i++){
+		const Bounds& b(V[i]);
+		// bodies without bbox don't collide
+		if(!b.flags.hasBB) continue;
+		const Particle::id_t id=b.id;
+		if(b.flags.isMin){
+			for(const Particle::id_t& o: (isNew[id]?openAll:openNew)) handleBoundInversion(id,o,/*separating*/false);
+			openAdd(openAll,posAll,id);
+			if(isNew[id]) openAdd(openNew,posNew,id);
+		} else {
+			openRemove(openAll,posAll,id);
+			if(isNew[id]) openRemove(openNew,posNew,id);
+		}
+	}
+}
+
+// map double to unsigned integer with the same ordering (flip all bits of negative numbers, the sign bit of positive ones)
+static inline uint64_t iscRadixKey(const Real& x){
+	uint64_t u; memcpy(&u,&x,sizeof(u));
+	return (u>>63)?~u:(u|(uint64_t(1)<<63));
+}
+
+void InsertionSortCollider::radixSortBounds(VecBounds& v){
+	assert((std::is_same<Real,double>::value));
+	const long n=(long)v.vec.size();
+	if(n<2) return;
+	radixItems.resize(n); radixTmp.resize(n);
+	// minima go first, so that the stable sort keeps them in front of maxima with the same coordinate (zero-width bodies, see Bounds::operator<)
+	long nMin=0;
+	for(const Bounds& b: v.vec) if(b.flags.isMin) nMin++;
+	for(long i=0, iMin=0, iMax=nMin; i<n; i++){
+		const Bounds& b(v.vec[i]);
+		radixItems[b.flags.isMin?iMin++:iMax++]=RadixItem{iscRadixKey(b.coord),(uint32_t)i};
+	}
+	// each chunk is histogrammed and scattered independently, by one thread; the result does not depend on the number of threads
+	#ifdef WOO_OPENMP
+		const long nChunks=std::max(1L,std::min((long)omp_get_max_threads(),n/4096));
+	#else
+		const long nChunks=1;
+	#endif
+	radixHist.resize(nChunks*256);
+	for(int shift=0; shift<64; shift+=8){
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(long c=0; c<nChunks; c++){
+			size_t* h=&radixHist[c*256];
+			std::fill(h,h+256,0);
+			for(long i=c*n/nChunks; i<(c+1)*n/nChunks; i++) h[(radixItems[i].key>>shift)&255]++;
+		}
+		// exclusive prefix sum over (digit,chunk); skip the pass if all keys have the same digit (typically the exponent bits)
+		size_t sum=0; bool trivial=false;
+		for(int d=0; d<256; d++){
+			size_t dSum=0;
+			for(long c=0; c<nChunks; c++){ size_t& h(radixHist[c*256+d]); size_t cnt=h; h=sum; sum+=cnt; dSum+=cnt; }
+			if(dSum==(size_t)n){ trivial=true; break; }
+		}
+		if(trivial) continue;
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(static)
+		#endif
+		for(long c=0; c<nChunks; c++){
+			size_t* h=&radixHist[c*256];
+			for(long i=c*n/nChunks; i<(c+1)*n/nChunks; i++) radixTmp[h[(radixItems[i].key>>shift)&255]++]=radixItems[i];
+		}
+		radixItems.swap(radixTmp);
+	}
+	// permute bounds
+	if((long)radixBounds.size()!=n) radixBounds.assign(n,v.vec[0]);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long i=0; i<n; i++) radixBounds[i]=v.vec[radixItems[i].ix];
+	v.vec.swap(radixBounds);
+}
+
 // return floating value wrapped between x0 and x1 and saving period number to period
 Real InsertionSortCollider::cellWrap(const Real x, const Real x0, const Real x1, int& period){
 	Real xNorm=(x-x0)/(x1-x0);
@@ -670,18 +823,21 @@ Real InsertionSortCollider::cellWrapRel(const Real x, const Real x0, const Real
 void InsertionSortCollider::insertionSortPeri(VecBounds& v, bool doCollide, int ax){
 	assert(periodic);
 	assert(v.size==(long)v.vec.size());
+	sortPasses[ax]=1;
+	if(v.size==0) return;
 	#ifndef WOO_OPENMP
-		insertionSortPeri_part(v,doCollide,ax,0,v.size,0);
+		v.loIdx=insertionSortPeri_part(v,doCollide,ax,0,v.size,0);
 		// insertionSortPeri_orig(v,doCollide,ax);
 	#else
-		// one chunk per core; the complicated logic for the non-periodic variant has not brought any improvement
-		int chunks=omp_get_max_threads();
-		int chunkSize=v.size/chunks;
-		if(chunkSize<100 || !paraPeri){
-			if(v.size>0) insertionSortPeri_part(v,doCollide,ax,0,v.size,0);
+		// the same chunking as for the aperiodic sort
+		size_t chunks=(paraPeri?sortChunkCount(v.size):1);
+		size_t chunkSize=v.size/chunks;
+		if(chunks==1 || chunkSize<100){
+			v.loIdx=insertionSortPeri_part(v,doCollide,ax,0,v.size,0);
 			// insertionSortPeri_orig(v,doCollide,ax);
 			return;
 		}
+		sortChunks=chunks; // for diagnostics
 
 		/*
 			============================================= bound sequence
@@ -689,95 +845,90 @@ void InsertionSortCollider::insertionSortPeri(VecBounds& v, bool doCollide, int
 			0----------1----------2----------3----------4         splits0 (even sorts run in-between)
 			.....0----------1-----------2----------3-----.....4   splits1 (odd sorts run in-between); 4 wraps to 0
 
-			Split-points inner to bounds are checked for ordering after each pass;
+			Since the sequence is circular, there are as many odd chunks as even ones, and the last odd
+			chunk spans the end of the array (indices are normalized inside insertionSortPeri_part).
+			All split-points are inner to the sequence and are checked for ordering after each pass;
 			when all of them are ordered, it means the whole sequence is ordered.
 
+			The split (loIdx) is owned by the chunk containing it; only that chunk moves it (always
+			within its range) and returns its new position, which is written back after the pass.
 		*/
 		vector<size_t> splits0(chunks+1), splits1(chunks+1);
-		for(int i=0; i<chunks; i++){ splits0[i]=i*chunkSize; splits1[i]=i*chunkSize+chunkSize/2; }
+		for(size_t i=0; i<chunks; i++){ splits0[i]=i*chunkSize; splits1[i]=i*chunkSize+chunkSize/2; }
 		splits0[chunks]=v.size;
 		splits1[chunks]=splits1[0]+v.size; // wrapping around
-		//cerr<<"splits0:"; for(auto s: splits0) cerr<<" "<<s; cerr<<endl;
-		//cerr<<"splits1:"; for(auto s: splits1) cerr<<" "<<s; cerr<<endl;
 		
 		bool isOk=false; size_t pass;
 		for(pass=0; !isOk; pass++){
 			bool even=((pass%2)==0);
 			const vector<size_t>& s(even?splits0:splits1);
+			long loIdx=-1;
 			#pragma omp parallel for schedule(static)
-			for(int chunk=0; chunk<chunks; chunk++){
+			for(size_t chunk=0; chunk<chunks; chunk++){
 				long start(pass==0?s[chunk]:(even?splits1[chunk]:splits0[chunk+1]));
-				// cerr<<"{pass:"<<pass<<",chunk:"<<chunk<<"/"<<chunks-1<<":"<<s[chunk]<<","<<s[chunk+1]<<","<<start<<"}";
-				insertionSortPeri_part(v,doCollide,ax,s[chunk],s[chunk+1],start);
+				long lo=insertionSortPeri_part(v,doCollide,ax,s[chunk],s[chunk+1],start);
+				if(lo>=0) loIdx=lo; // only one chunk owns the split
 			}
+			assert(loIdx>=0);
+			v.loIdx=loIdx;
 			isOk=true;
-			// if(pass<=3) isOk=false;
-			for(int chunk=0; chunk<chunks; chunk++){
-				// cerr<<"["<<chunk<<"/"<<chunks-1<<"]";
+			for(size_t chunk=0; chunk<chunks; chunk++){
 				long i=v.norm(s[chunk]); long i_1=v.norm(i-1);
 				// this condition is copied over from the InsertionSortPeri_part loop
 				if((i==v.loIdx && v[i].coord<0) || v[i_1].coord>v[i].coord+(i==v.loIdx?v.cellDim:0)){ isOk=false; break; }
 			}
 		}
-		// cerr<<" (("<<pass<<" passes))"<<endl;
+		sortPasses[ax]=pass;
 		// cerr<<"Parallel periodic insertion sort done ("<<pass+1<<") passes, "<<chunks<<" chunks; inversions remaining: "<<countInversions().transpose()<<endl;
 	#endif
 }
-void InsertionSortCollider::insertionSortPeri_part(VecBounds& v, bool doCollide, int ax, long iBegin, long iEnd, long iStart){
+
+long InsertionSortCollider::insertionSortPeri_part(VecBounds& v, bool doCollide, int ax, long iBegin, long iEnd, long iStart){
 	assert(periodic);
 	assert(iBegin<iEnd);
-	// iBegin must be in the normalized range
+	// iBegin must be in the normalized range; iEnd may be beyond v.size, if the range wraps around
 	assert(v.norm(iBegin)==iBegin);
-	assert(0<=iEnd);
+	assert(iEnd<=iBegin+v.size);
 	assert(iStart<iEnd);
-	long &loIdx=v.loIdx;
-	#ifdef WOO_OPENMP
-		const bool earlyStop=(iBegin!=iStart);
-		const bool partial=(v.norm(iBegin)!=v.norm(iEnd));
-		// cerr<<"[["<<iBegin<<","<<iEnd<<"("<<v.norm(iEnd)<<"),"<<iStart<<"]]";
-	#else
-		const bool earlyStop=false;
-		const bool partial=false;
-		assert(iBegin==iStart);
-		assert(v.norm(iBegin)==v.norm(iEnd));
-	#endif
+	// stop after encountering the first ordered couple; this is used from the parallel sort
+	const bool earlyStop=(iBegin!=iStart);
+	// sorting only [iBegin,iEnd) (one chunk of the parallel sort)
+	const bool partial=(v.norm(iBegin)!=v.norm(iEnd));
+	assert(partial || !earlyStop);
+	// work on a local copy of the split; if outside of our range, it is never moved by us, and -1 never matches any index
+	const bool ownLo=(!partial || v.norm(v.loIdx-iBegin)<iEnd-iBegin);
+	long loIdx=(ownLo?v.loIdx:-1);
 	// don't start at iBegin+1 for partial sort, since we may need to adjust loIdx at that index as well
 	// for single-threaded sort, we need iBegin, since j may go down arbitrarily (smaller than iBegin)
 	for(long _i=max(iStart,iBegin); _i<iEnd; _i++){
-		// TODO: check that we threads cannot change loIdx concurrently!!!
 		const long i=v.norm(_i);
-		const long i_1=v.norm(i-1);
 		// switch period of (i) if the coord is below the lower edge cooridnate-wise and just above the split
-		// make sure we don't push loIdx up to other parallel thread's range
-		if(i==loIdx && v[i].coord<0 && (!partial || i!=iEnd-1)){ v[i].period-=1; v[i].coord+=v.cellDim; loIdx=v.norm(loIdx+1); }
+		// make sure we don't push loIdx out of our range
+		if(i==loIdx && v[i].coord<0 && (!partial || _i!=iEnd-1)){ v[i].period-=1; v[i].coord+=v.cellDim; loIdx=v.norm(loIdx+1); }
+		// the first element of a chunk is compared with the previous chunk after the pass (by the caller)
+		if(partial && _i==iBegin) continue;
+		const long i_1=v.norm(i-1);
 		// coordinate of v[i] used to check inversions
 		// if crossing the split, adjust by cellDim;
 		// if we get below the loIdx however, the v[i].coord will have been adjusted already, no need to do that here
 		const Real iCmpCoord=v[i].coord+(i==loIdx ? v.cellDim : 0); 
 		// no inversion, early return
 		if(v[i_1].coord<=iCmpCoord){
-			if(unlikely(earlyStop)){ return; }
+			if(unlikely(earlyStop)) break;
 			continue;
 		}
 		// vi is the copy that will travel down the list, while other elts go up
 		// if will be placed in the list only at the end, to avoid extra copying
-		int j=i_1; Bounds vi=v[i];  const bool viHasBB=vi.flags.hasBB; const bool viIsMin=vi.flags.isMin; const bool viIsInf=vi.flags.isInf;
-		while((!partial || j>=iBegin) && v[j].coord>vi.coord + /* wrap for elt just below split */ (v.norm(j+1)==loIdx ? v.cellDim : 0)){
+		// _j is not normalized, to be compared with iBegin
+		long _j=_i-1; long j=i_1; Bounds vi=v[i];  const bool viHasBB=vi.flags.hasBB; const bool viIsMin=vi.flags.isMin; const bool viIsInf=vi.flags.isInf;
+		while((!partial || _j>=iBegin) && v[j].coord>vi.coord + /* wrap for elt just below split */ (v.norm(j+1)==loIdx ? v.cellDim : 0)){
 			long j1=v.norm(j+1);
 			// OK, now if many bodies move at the same pace through the cell and at one point, there is inversion,
 			// this can happen without any side-effects
-			#if 0
-				if (v[j].coord>2*v.cellDim){
-					// this condition is not strictly necessary, but the loop of insertionSort would have to run more times.
-					// Since size of particle is required to be < .5*cellDim, this would mean simulation explosion anyway
-					LOG_FATAL("Particle #"<<v[j].id<<" going faster than 1 cell in one step? Not handled.");
-					throw runtime_error(__FILE__ ": particle moving too fast (skipped 1 cell).");
-				}
-			#endif
 			Bounds& vNew(v[j1]); // elt at j+1 being overwritten by the one at j and adjusted
 			vNew=v[j];
 			// inversions close the the split need special care
-			// parallel: loIdx modification is safe since j>iBegin (when loIdx is incremented) and j1>iBegin+1 (when loIdx is decremented);
+			// parallel: loIdx stays in our range, since j1>iBegin (when loIdx is incremented) and j>=iBegin (when loIdx is decremented)
 			if(unlikely(j==loIdx && vi.coord<0)) { vi.period-=1; vi.coord+=v.cellDim; loIdx=v.norm(loIdx+1); }
 			else if(unlikely(j1==loIdx)) { vNew.period+=1; vNew.coord-=v.cellDim; loIdx=v.norm(loIdx-1); }
 			if(viIsMin!=v[j].flags.isMin && likely(doCollide && viHasBB && v[j].flags.hasBB)){
@@ -792,10 +943,11 @@ void InsertionSortCollider::insertionSortPeri_part(VecBounds& v, bool doCollide,
 				#endif
 				{ stepInvs[ax]++; numInvs[ax]++; }
 			#endif
-			j=v.norm(j-1);
+			_j--; j=v.norm(j-1);
 		}
 		v[v.norm(j+1)]=vi;
 	}
+	return ownLo?loIdx:-1;
 }
 
 
@@ -104,7 +104,7 @@ struct InsertionSortCollider: public Collider {
 		void removeContactLater(const shared_ptr<Contact>& C){ removeContacts.push_back(C); }
 	#endif
 	void makeContactLater(const shared_ptr<Particle>& pA, const shared_ptr<Particle>& pB, const Vector3i& cellDist=Vector3r::Zero()){
-		shared_ptr<Contact> C=make_shared<Contact>(); C->pA=pA; C->pB=pB; C->cellDist=cellDist; C->stepCreated=scene->step;
+		shared_ptr<Contact> C=woo::slab_make_shared<Contact>(); C->pA=pA; C->pB=pB; C->cellDist=cellDist; C->stepCreated=scene->step;
 		#ifdef WOO_OPENMP
 			mmakeContacts[omp_get_thread_num()].push_back(C);
 		#else
@@ -171,8 +171,32 @@ struct InsertionSortCollider: public Collider {
 	VecBounds BB[3];
 	//! storage for bb maxima and minima
 	std::vector<Real> maxima, minima;
+	// particles of which bounds were updated in this step (from BoundDispatcher::dirty), indexed by id
+	std::vector<char> dirtyMask;
+	// per-particle state for copying bounds, indexed by id (combination of PAR_* bits)
+	enum{ PAR_EXISTS=1, PAR_HASBB=2, PAR_COPY=4 };
+	std::vector<unsigned char> parState;
+	// particles which did not exist in the previous full run (only with incInsert), indexed by id
+	std::vector<char> isNew;
+	std::vector<Bounds> newBounds;
+	// sort existing bounds and merge those of new particles (isNew) into them, then find contacts of new particles
+	void insertNewBounds(long nPar);
+	// full sort of bounds along one axis, with parallel LSD radix sort; stable, minima before maxima at equal coordinates
+	void radixSortBounds(VecBounds& v);
+	struct RadixItem{ uint64_t key; uint32_t ix; };
+	std::vector<RadixItem> radixItems, radixTmp;
+	std::vector<size_t> radixHist;
+	std::vector<Bounds> radixBounds;
 	//! Whether the Scene was periodic (to detect the change, which shouldn't happen, but shouldn't crash us either)
 	bool periodic;
+	// sort timing over the current window: number of sorts, passes and nanoseconds
+	long tuneSteps, tunePasses; TimingInfo::delta tuneNsec;
+	// ompTuneAuto state: index of the candidate being measured (-1 when not tuning), best time per step and its chunks per core, number of particles when tuning started
+	int tuneCand, tuneBestCpc; Real tuneBest; long tuneNPar;
+	// value of ompTuneSort as set by the tuning (or the default); if ompTuneSort differs, it was set by the user and is not tuned
+	Vector3i tuneSet;
+	// account for one (regular) sort of all axes, and adjust ompTuneSort with ompTuneAuto
+	void sortTimingUpdate(TimingInfo::delta nsec, long nPar);
 
 	protected:
 	// updated at every step
@@ -188,13 +212,18 @@ struct InsertionSortCollider: public Collider {
 	*/
 	Vector3i countInversions(); // for debugging only
 	void insertionSort(VecBounds& v,bool doCollide=true, int ax=0);
+	#ifdef WOO_OPENMP
+		// number of chunks for the parallel sort of n bounds, from ompTuneSort
+		size_t sortChunkCount(long n);
+	#endif
 	void insertionSort_part(VecBounds& v, bool doCollide, int ax, long iBegin, long iEnd, long iStart);
 	void handleBoundInversion(Particle::id_t,Particle::id_t, bool separating);
 	bool spatialOverlap(Particle::id_t,Particle::id_t) const;
 
 	// periodic variants
 	void insertionSortPeri(VecBounds& v,bool doCollide=true, int ax=0);
-	void insertionSortPeri_part(VecBounds& v, bool doCollide, int ax, long iBegin, long iEnd, long iStart);
+	// returns the new split (loIdx) of v if it is in [iBegin,iEnd), -1 otherwise; v.loIdx itself is not modified
+	long insertionSortPeri_part(VecBounds& v, bool doCollide, int ax, long iBegin, long iEnd, long iStart);
 	// fallback, hopefully bug-free original version
 	void insertionSortPeri_orig(VecBounds& v,bool doCollide=true, int ax=0);
 	void handleBoundInversionPeri(Particle::id_t,Particle::id_t, bool separating);
@@ -266,8 +295,19 @@ struct InsertionSortCollider: public Collider {
 		((shared_ptr<BoundDispatcher>,boundDispatcher,make_shared<BoundDispatcher>(),AttrTrait<Attr::readonly>(),":obj:`BoundDispatcher` object that is used for creating :obj:`bounds <Particle.bound>` on collider's request as necessary."))
 		((Vector3i,ompTuneSort,Vector3i(1,1000,0),,"Fine-tuning for the OpenMP-parallellized partial insertion sort. The first number is the number of chunks per CPU (2 means each core will process 2 chunks sequentially, on average). The second number (if positive) is the lower bound on number of particles per chunk; the third number (if positive) is the limit of bounds per one chunk (15000 means that if there are e.g. 300k particles, bounds will be processed in 20 chunks, even if the number of chunks from the first number is smaller)."))
 		((int,sortChunks,-1,AttrTrait<Attr::readonly>(),"Number of threads that were actually used during the last parallelized insertion sort."))
-		((bool,paraPeri,false,,"(debugging only): enable/disable(default) parallel sort with periodic boundaries."))
+		((bool,ompTuneAuto,true,,"Tune :obj:`ompTuneSort` automatically: the sort time is measured over :obj:`ompTuneWindow` sorts for 1, 2, 4, … chunks per core (until it gets slower than the best one, or chunks get too small to be sorted in parallel); the fastest number of chunks per core is then used, and particles per chunk are bounded to half and double of the tuned chunk size, so that the number of chunks follows the number of particles. Tuning is restarted when the number of particles changes more than twice. Results are in :obj:`ompTuneTimings`. Tuning stops once :obj:`ompTuneSort` is set by the user (to a value other than the default or the one found by tuning)."))
+		((int,ompTuneWindow,20,,"Number of sorts over which :obj:`sortPassTime` is averaged (and each :obj:`ompTuneAuto` candidate is measured)."))
+		((vector<Vector3r>,ompTuneTimings,,AttrTrait<Attr::readonly|Attr::noSave>(),"Results of the last :obj:`ompTuneAuto` tuning: chunks per core, time per sort of all axes, time per pass (in seconds)."))
+		((Vector3i,sortPasses,Vector3i::Zero(),AttrTrait<Attr::readonly|Attr::noSave>(),"Number of passes of the last insertion sort along each axis (1 for sequential sort)."))
+		((Real,sortPassTime,NaN,AttrTrait<Attr::readonly|Attr::noSave>(),"Average time (in seconds) of one pass of the insertion sort, over the last :obj:`ompTuneWindow` sorts."))
+		((bool,paraPeri,true,,"Use the parallel insertion sort (chunked as set by :obj:`ompTuneSort`) with periodic boundaries as well."))
 		((bool,periDbgNew,false,,"Compute periodic overlaps and periods twice (with the original and the new algorithm) compare the results and report discrepancies."))
+		((bool,incInsert,true,,"Insert bounds of new particles (appended, or re-using ids of removed particles) into the sorted arrays by sorting and merging, and only trim bounds of particles removed from the end of the container; both avoid the initial sort, which was run previously when more than 100 particles were added or any were removed. Contacts of new particles are found in one sweep along :obj:`sortAxis`. Not used with periodic boundaries."))
+		((int,numIncInsert,0,AttrTrait<Attr::readonly>(),"Cumulative number of incremental insertions of new particles (see :obj:`incInsert`)."))
+		((bool,radixSort,true,,"Use parallel radix sort (rather than comparison sort) for the initial sort of bounds, which is run when many particles were added or with :obj:`forceInitSort`. Only used when ``Real`` is double."))
+		((bool,paraInitSweep,true,,"Traverse sorted bounds in parallel when creating contacts after the initial sort. Not used with :obj:`Scene.deterministic`, since the order of contacts then depends on thread scheduling."))
+		((bool,paraLater,true,,"Add and remove contacts collected during the sort in parallel, using the concurrent mode of :obj:`ContactContainer` (contacts of particles are updated under striped spinlocks, not lock-free). Not used with :obj:`Scene.deterministic`, since the order of contacts then depends on thread scheduling."))
+		((int,paraLaterMin,1000,,"Minimum number of contacts to be added or removed for :obj:`paraLater` to be used; smaller batches are processed serially."))
 		,
 		/* ctor */
 			#ifdef ISC_TIMING
@@ -281,6 +321,8 @@ struct InsertionSortCollider: public Collider {
 				rremoveContacts.resize(omp_get_max_threads());
 			#endif
 			for(int i=0; i<3; i++) BB[i].axis=i;
+			tuneSteps=tunePasses=0; tuneNsec=0;
+			tuneCand=-1; tuneBestCpc=1; tuneBest=Inf; tuneNPar=0; tuneSet=ompTuneSort;
 			periodic=false;
 			strideActive=false;
 			,
@@ -288,7 +330,7 @@ struct InsertionSortCollider: public Collider {
 		.def_readonly("strideActive",&InsertionSortCollider::strideActive,"Whether striding is active (read-only; for debugging).")
 		.def_readonly("periodic",&InsertionSortCollider::periodic,"Whether the collider is in periodic mode (read-only; for debugging)")
 		.def_readonly("minima",&InsertionSortCollider::minima,"Array of minimum bbox coords; every 3 contiguous values are x, y,z for one particle")
-		.def_readonly("maxima",&InsertionSortCollider::minima,"Array of maximum bbox coords; every 3 contiguous values are x, y, z for one particle")
+		.def_readonly("maxima",&InsertionSortCollider::maxima,"Array of maximum bbox coords; every 3 contiguous values are x, y, z for one particle")
 		.def("dumpBounds",&InsertionSortCollider::dumpBounds,"Return representation of the internal sort data. The format is ``([...],[...],[...])`` for 3 axes, where each ``...`` is a list of entries (bounds). The entry is a tuple with the fllowing items:\n\n* coordinate (float)\n* body id (int), but negated for negative bounds\n* period numer (int), if the collider is in the periodic regime.")
 		.def("dbgInfo",&InsertionSortCollider::dbgInfo,"Return python distionary with information on some internal structures (debugging only)")
 		.def("spatialOverlap",&InsertionSortCollider::pySpatialOverlap,(py::arg("scene"),py::arg("id1"),py::arg("id2")),"Debug access to the spatial overlap function.")
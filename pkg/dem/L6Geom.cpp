@@ -49,7 +49,7 @@ WOO_IMPL_LOGGER(Cg2_Any_Any_L6Geom__Base);
 void Cg2_Any_Any_L6Geom__Base::handleSpheresLikeContact(const shared_ptr<Contact>& C, const Vector3r& pos1, const Vector3r& vel1, const Vector3r& angVel1, const Vector3r& pos2, const Vector3r& vel2, const Vector3r& angVel2, const Vector3r& normal, const Vector3r& contPt, Real uN, Real r1, Real r2){
 	// create geometry
 	if(!C->geom){
-		C->geom=make_shared<L6Geom>();
+		C->geom=woo::slab_make_shared<L6Geom>();
 		L6Geom& g(C->geom->cast<L6Geom>());
 		g.setInitialLocalCoords(normal);
 		g.uN=uN;
@@ -133,6 +133,8 @@ void Leapfrog::run(){
 	DemField* dem=dynamic_cast<DemField*>(field.get());
 	assert(dem);
 	bool hasGravity(dem->gravity!=Vector3r::Zero());
+	// add per-thread contact forces (ContactLoop.threadForces), before anything reads DemData::force
+	dem->threadForcesReduce();
 
 	if(dem->nodes.empty()){
 		Master::instance().checkApi(/*minApi*/10101,"DemField.nodes is empty; woo.dem.Leapfrog no longer calls DemField.collectNodes() automatically.",/*pyWarn*/true); // can happen in bg thread?
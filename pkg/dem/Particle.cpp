@@ -461,8 +461,25 @@ void DemField::pyNodesAppendFromParticles(const vector<shared_ptr<Particle>>& pp
 	}
 }
 
+void DemField::threadForcesReduce(){
+	if(!threadForcesPending) return;
+	const size_t sz=min(nodes.size(),threadForce.size());
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(size_t i=0; i<sz; i++){
+		DemData& dyn=nodes[i]->getData<DemData>();
+		dyn.force+=threadForce.get(i); dyn.torque+=threadTorque.get(i);
+		threadForce.reset(i); threadTorque.reset(i);
+	}
+	// entries past the end of nodes (removed meanwhile) are dropped, new entries are zeroed when growing again
+	threadForce.resize(sz); threadTorque.resize(sz);
+	threadForcesPending=false;
+}
+
 void DemField::removeParticle(Particle::id_t id){
 	LOG_DEBUG("Removing #"<<id);
+	threadForcesReduce(); // linIx of nodes might change
 	assert(id>=0);
 	assert((int)particles->size()>id);
 	// don't actually delete the particle until before returning, so that p is not dangling
@@ -512,6 +529,7 @@ void DemField::removeParticle(Particle::id_t id){
 };
 
 void DemField::removeClump(size_t linIx){
+	threadForcesReduce();
 	if(linIx>nodes.size()) throw std::runtime_error("DemField.removeClump("+to_string(linIx)+"): invalid index.");
 	if(!nodes[linIx]) throw std::runtime_error("DemField.removeClump: DemField.nodes["+to_string(linIx)+"]=None.");
 	const auto& node=nodes[linIx];
@@ -6,6 +6,8 @@
 #include<woo/core/Field-templates.hpp>
 #include<woo/pkg/dem/ParticleContainer.hpp>
 #include<woo/pkg/dem/ContactContainer.hpp>
+#include<woo/pkg/dem/ParticleContactIndex.hpp>
+#include<woo/lib/base/openmp-accu.hpp>
 #include<woo/lib/pyutil/converters.hpp>
 #include<atomic>
 #include<boost/utility/binary.hpp>
@@ -26,8 +28,8 @@ struct ScalarRange;
 struct Particle: public Object{
 	shared_ptr<Contact> findContactWith(const shared_ptr<Particle>& other);
 	typedef ParticleContainer::id_t id_t;
-	// try unordered_map
-	typedef std::map<id_t,shared_ptr<Contact> > MapParticleContact;
+	// compact map-like index (sorted small vector, open-addressing hash for many contacts)
+	typedef ParticleContactIndex MapParticleContact;
 	void checkNodes(bool dyn=true, bool checkOne=true) const;
 	void selfTest();
 
@@ -293,6 +295,12 @@ struct DemField: public Field{
 	vector<shared_ptr<Node>> splitNode(const shared_ptr<Node>&, const vector<shared_ptr<Particle>>& pp, const Real massMult=NaN, const Real inertiaMult=NaN);
 	AlignedBox3r renderingBbox() const WOO_CXX11_OVERRIDE; // overrides Field::renderingBbox
 	boost::mutex nodesMutex; // sync adding nodes with the renderer, which might otherwise crash
+	/* per-thread force/torque accumulators indexed by DemData::linIx, filled by ContactLoop (with ContactLoop.threadForces)
+	and added to DemData::force and DemData::torque by threadForcesReduce, which is called by Leapfrog before forces are used;
+	also called before nodes are removed, since that changes DemData::linIx of other nodes. Not saved. */
+	OpenMPArrayAccumulator<Vector3r> threadForce, threadTorque;
+	bool threadForcesPending=false;
+	void threadForcesReduce();
 
 	void selfTest() WOO_CXX11_OVERRIDE;
 
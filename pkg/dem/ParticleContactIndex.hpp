@@ -0,0 +1,129 @@
+#pragma once
+#include<woo/lib/base/Types.hpp>
+#include<vector>
+#include<utility>
+#include<algorithm>
+#include<cstdint>
+
+struct Contact;
+
+/*
+Per-particle index of contacts, keyed by id of the other particle; used as Particle::contacts.
+
+Behaves like a subset of std::map (find, count, operator[], erase, iteration over pairs
+with ->first being the id and ->second the contact), but stores (id,contact) pairs in
+a single contiguous vector:
+
+* up to hashThreshold items (the usual case for particles with coordination number ~4-20),
+  the vector is kept sorted by id and searched linearly; iteration is in increasing id order, as with std::map;
+* above that (walls, facets, large particles), an open-addressing table (linear probing) of indices
+  into the vector is maintained; items are appended and removed by swapping with the last one,
+  hence iteration order is not sorted anymore.
+
+Erasing invalidates iterators pointing to the erased item and past it (the last one, in the hashed mode).
+*/
+class ParticleContactIndex{
+public:
+	typedef int key_type; // ParticleContainer::id_t
+	typedef shared_ptr<Contact> mapped_type;
+	typedef std::pair<key_type,mapped_type> value_type;
+	typedef std::vector<value_type> storage_type;
+	typedef storage_type::iterator iterator;
+	typedef storage_type::const_iterator const_iterator;
+	enum{ hashThreshold=16 };
+
+	ParticleContactIndex(): tombstones(0){}
+
+	iterator begin(){ return items.begin(); }
+	iterator end(){ return items.end(); }
+	const_iterator begin() const { return items.begin(); }
+	const_iterator end() const { return items.end(); }
+	size_t size() const { return items.size(); }
+	bool empty() const { return items.empty(); }
+	void clear(){ items.clear(); table.clear(); tombstones=0; }
+	bool isHashed() const { return !table.empty(); }
+
+	iterator find(key_type id){ return items.begin()+findIx(id); }
+	const_iterator find(key_type id) const { return items.begin()+findIx(id); }
+	size_t count(key_type id) const { return findIx(id)<items.size()?1:0; }
+
+	// insert (id,c) unless id is already present; return iterator to the item for id and whether it was inserted
+	std::pair<iterator,bool> insert(const value_type& v){
+		size_t ix=findIx(v.first);
+		if(ix<items.size()) return std::make_pair(items.begin()+ix,false);
+		if(!isHashed()){
+			if(items.size()<hashThreshold){
+				iterator I=std::lower_bound(items.begin(),items.end(),v.first,[](const value_type& a, key_type b){ return a.first<b; });
+				return std::make_pair(items.insert(I,v),true);
+			}
+			items.push_back(v);
+			rehash();
+			return std::make_pair(items.end()-1,true);
+		}
+		items.push_back(v);
+		if(2*(items.size()+tombstones)>table.size()) rehash();
+		else tableInsert(v.first,items.size()-1);
+		return std::make_pair(items.end()-1,true);
+	}
+	mapped_type& operator[](key_type id){ return insert(value_type(id,mapped_type())).first->second; }
+
+	void erase(iterator I){
+		if(!isHashed()){ items.erase(I); return; }
+		size_t ix=I-items.begin(), last=items.size()-1;
+		*tableSlot(I->first)=TOMBSTONE; tombstones++;
+		if(ix!=last){
+			*tableSlot(items[last].first)=(int)ix;
+			items[ix]=std::move(items[last]);
+		}
+		items.pop_back();
+		if(items.size()<hashThreshold/2){
+			// back to the small sorted mode
+			table.clear(); tombstones=0;
+			std::sort(items.begin(),items.end(),[](const value_type& a, const value_type& b){ return a.first<b.first; });
+		}
+		else if(tombstones>items.size()) rehash();
+	}
+	size_t erase(key_type id){
+		iterator I=find(id);
+		if(I==end()) return 0;
+		erase(I); return 1;
+	}
+private:
+	enum{ EMPTY=-1, TOMBSTONE=-2 };
+	storage_type items;
+	std::vector<int> table;
+	size_t tombstones;
+
+	size_t hashSlot(key_type id) const { return (size_t)((uint32_t)id*2654435761u)&(table.size()-1); }
+	// index of id in items, or items.size() if not found
+	size_t findIx(key_type id) const {
+		if(!isHashed()){
+			for(size_t i=0; i<items.size(); i++){
+				if(items[i].first==id) return i;
+				if(items[i].first>id) break; // sorted
+			}
+			return items.size();
+		}
+		for(size_t s=hashSlot(id); ; s=(s+1)&(table.size()-1)){
+			const int& t=table[s];
+			if(t==EMPTY) return items.size();
+			if(t>=0 && items[t].first==id) return t;
+		}
+	}
+	// slot holding id; id must be present
+	int* tableSlot(key_type id){
+		for(size_t s=hashSlot(id); ; s=(s+1)&(table.size()-1)){
+			if(table[s]>=0 && items[table[s]].first==id) return &table[s];
+		}
+	}
+	void tableInsert(key_type id, size_t ix){
+		for(size_t s=hashSlot(id); ; s=(s+1)&(table.size()-1)){
+			if(table[s]<0){ if(table[s]==TOMBSTONE) tombstones--; table[s]=(int)ix; return; }
+		}
+	}
+	void rehash(){
+		size_t sz=16; while(sz<4*items.size()) sz*=2;
+		table.assign(sz,EMPTY); tombstones=0;
+		for(size_t i=0; i<items.size(); i++) tableInsert(items[i].first,i);
+	}
+};
@@ -0,0 +1,92 @@
+#include<woo/pkg/dem/SpatialReorder.hpp>
+#include<woo/pkg/dem/Contact.hpp>
+#include<woo/pkg/dem/ContactContainer.hpp>
+
+WOO_PLUGIN(dem,(SpatialReorder));
+WOO_IMPL_LOGGER(SpatialReorder);
+WOO_IMPL__CLASS_BASE_DOC_ATTRS(woo_dem_SpatialReorder__CLASS_BASE_DOC_ATTRS);
+
+uint64_t SpatialReorder::mortonKey(const Vector3r& x, const AlignedBox3r& box){
+	if(!x.allFinite()) return (uint64_t(1)<<63)-1; // after all finite ones
+	uint64_t ret=0;
+	for(int ax:{0,1,2}){
+		const Real sz=box.sizes()[ax];
+		const Real rel=(sz>0?(x[ax]-box.min()[ax])/sz:0.);
+		uint64_t v=(uint64_t)std::min(std::max(rel*(1<<21),(Real)0.),(Real)((1<<21)-1));
+		// spread 21 bits so that there are two zero bits between each of them
+		v=(v|(v<<32))&0x1f00000000ffffULL;
+		v=(v|(v<<16))&0x1f0000ff0000ffULL;
+		v=(v|(v<<8)) &0x100f00f00f00f00fULL;
+		v=(v|(v<<4)) &0x10c30c30c30c30c3ULL;
+		v=(v|(v<<2)) &0x1249249249249249ULL;
+		ret|=(v<<ax);
+	}
+	return ret;
+}
+
+Vector3r SpatialReorder::keyPos(const Vector3r& pos) const {
+	if(!scene->isPeriodic) return pos;
+	return scene->cell->wrapPt(scene->cell->unshearPt(pos));
+}
+
+void SpatialReorder::reorderNodes(DemField& dem, const AlignedBox3r& box){
+	// accumulated forces are indexed by linIx, which is about to change
+	dem.threadForcesReduce();
+	const long N=dem.nodes.size();
+	vector<std::pair<uint64_t,long>> keys(N);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long i=0; i<N; i++) keys[i]=std::make_pair(mortonKey(keyPos(dem.nodes[i]->pos),box),i);
+	// pairs are unique thanks to the index, hence the result does not depend on the sort algorithm
+	if(std::is_sorted(keys.begin(),keys.end())) return;
+	std::sort(keys.begin(),keys.end());
+	vector<shared_ptr<Node>> sorted(N);
+	for(long i=0; i<N; i++){
+		sorted[i]=dem.nodes[keys[i].second];
+		sorted[i]->getData<DemData>().linIx=i;
+	}
+	boost::mutex::scoped_lock lock(dem.nodesMutex);
+	dem.nodes.swap(sorted);
+}
+
+void SpatialReorder::reorderContacts(DemField& dem, const AlignedBox3r& box){
+	ContactContainer& cc(*dem.contacts);
+	#if defined(WOO_OPENMP) || defined(WOO_OPENGL)
+		boost::mutex::scoped_lock lock(cc.manipMutex);
+	#endif
+	const long N=cc.size();
+	vector<std::pair<uint64_t,long>> keys(N);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long i=0; i<N; i++){
+		const shared_ptr<Contact>& C(cc[i]);
+		const Particle* pA=(C->pA.expired()?NULL:C->leakPA());
+		uint64_t key=(pA && pA->shape && !pA->shape->nodes.empty())?mortonKey(keyPos(pA->shape->nodes[0]->pos),box):(uint64_t(1)<<63)-1;
+		// real contacts first
+		if(!C->isReal()) key|=(uint64_t(1)<<63);
+		keys[i]=std::make_pair(key,i);
+	}
+	if(std::is_sorted(keys.begin(),keys.end())) return;
+	std::sort(keys.begin(),keys.end());
+	vector<shared_ptr<Contact>> sorted(N);
+	for(long i=0; i<N; i++) sorted[i]=cc[keys[i].second];
+	for(long i=0; i<N; i++){
+		cc[i]=sorted[i];
+		cc[i]->linIx=i;
+	}
+}
+
+void SpatialReorder::run(){
+	DemField& dem(field->cast<DemField>());
+	AlignedBox3r box;
+	if(scene->isPeriodic) box=AlignedBox3r(Vector3r::Zero(),scene->cell->getSize());
+	else {
+		for(const auto& n: dem.nodes) if(n->pos.allFinite()) box.extend(n->pos);
+		if(box.isEmpty()) return;
+	}
+	if(nodes) reorderNodes(dem,box);
+	if(contacts) reorderContacts(dem,box);
+	nDone++;
+}
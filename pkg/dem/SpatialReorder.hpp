@@ -0,0 +1,33 @@
+#pragma once
+#include<woo/core/Engine.hpp>
+#include<woo/pkg/dem/Particle.hpp>
+
+/*
+Reorder DemField::nodes and contacts along the Morton (Z-order) curve, so that spatial neighbours
+are traversed one after another by Leapfrog and ContactLoop.
+
+Node::pos is quantized over the bounding box of all nodes (over the unsheared cell with periodic
+boundaries) with 21 bits per axis, and the bits are interleaved into one 63-bit key. Contacts are
+keyed by the first node of Contact::pA; real contacts are kept before non-real ones (as with
+ContactLoop.reorderEvery).
+*/
+struct SpatialReorder: public PeriodicEngine {
+	WOO_DECL_LOGGER;
+	bool acceptsField(Field* f) WOO_CXX11_OVERRIDE { return dynamic_cast<DemField*>(f); }
+	void run() WOO_CXX11_OVERRIDE;
+	// interleave lowest 21 bits of each coordinate
+	static uint64_t mortonKey(const Vector3r& x, const AlignedBox3r& box);
+	private:
+	// position used for ordering (canonicalized with periodic boundaries)
+	Vector3r keyPos(const Vector3r& pos) const;
+	void reorderNodes(DemField& dem, const AlignedBox3r& box);
+	void reorderContacts(DemField& dem, const AlignedBox3r& box);
+	public:
+	#define woo_dem_SpatialReorder__CLASS_BASE_DOC_ATTRS \
+		SpatialReorder,PeriodicEngine,"Reorder :obj:`DemField.nodes` and :obj:`contacts <DemField.con>` along the Morton (Z-order) space-filling curve, so that neighbouring nodes and contacts are also neighbours in memory traversed by :obj:`Leapfrog` and :obj:`ContactLoop`. :obj:`DemData.linIx` and :obj:`Contact.linIx` are updated accordingly; particles (and their ids) are not touched. Real contacts are moved before potential ones.", \
+		((bool,nodes,true,,"Reorder :obj:`DemField.nodes`.")) \
+		((bool,contacts,true,,"Reorder contacts.")) \
+		((int,nDone,0,AttrTrait<Attr::readonly>(),"Number of times reordering was done."))
+	WOO_DECL__CLASS_BASE_DOC_ATTRS(woo_dem_SpatialReorder__CLASS_BASE_DOC_ATTRS);
+};
+WOO_REGISTER_OBJECT(SpatialReorder);
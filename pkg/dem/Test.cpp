@@ -0,0 +1,3 @@
+#include<woo/pkg/dem/Test.hpp>
+WOO_PLUGIN(dem,(WooTestCp2_FrictMat_IceMat));
+WOO_IMPL__CLASS_BASE_DOC(woo_dem_WooTestCp2_FrictMat_IceMat__CLASS_BASE_DOC);
@@ -0,0 +1,12 @@
+#pragma once
+#include<woo/pkg/dem/FrictMat.hpp>
+#include<woo/pkg/dem/Ice.hpp>
+
+// functor for two different material types, so that the dispatcher swaps arguments for contacts where particle A has IceMat
+struct WooTestCp2_FrictMat_IceMat: public Cp2_FrictMat_FrictPhys{
+	FUNCTOR2D(FrictMat,IceMat);
+	#define woo_dem_WooTestCp2_FrictMat_IceMat__CLASS_BASE_DOC \
+		WooTestCp2_FrictMat_IceMat,Cp2_FrictMat_FrictPhys,"Compute :obj:`FrictPhys` for :obj:`FrictMat` + :obj:`IceMat` pairs like :obj:`Cp2_FrictMat_FrictPhys`; used to test dispatch of materials in swapped order."
+	WOO_DECL__CLASS_BASE_DOC(woo_dem_WooTestCp2_FrictMat_IceMat__CLASS_BASE_DOC);
+};
+WOO_REGISTER_OBJECT(WooTestCp2_FrictMat_IceMat);
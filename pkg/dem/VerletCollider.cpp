@@ -0,0 +1,312 @@
+#include<woo/pkg/dem/VerletCollider.hpp>
+#include<woo/pkg/dem/ParticleContainer.hpp>
+#include<woo/pkg/dem/Sphere.hpp>
+#include<woo/lib/base/SlabPool.hpp>
+#include<numeric>
+
+WOO_PLUGIN(dem,(VerletCollider));
+WOO_IMPL_LOGGER(VerletCollider);
+WOO_IMPL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_VerletCollider__CLASS_BASE_DOC_ATTRS_CTOR);
+
+void VerletCollider::pyHandleCustomCtorArgs(py::tuple& t, py::dict& d){
+	if(py::len(t)==0) return; // nothing to do
+	if(py::len(t)!=1) throw invalid_argument("VerletCollider optionally takes exactly one list of BoundFunctor's as non-keyword argument for constructor ("+to_string(py::len(t))+" non-keyword ards given instead)");
+	if(!boundDispatcher) boundDispatcher=make_shared<BoundDispatcher>();
+	vector<shared_ptr<BoundFunctor>> vf=py::extract<vector<shared_ptr<BoundFunctor>>>((t[0]))();
+	for(const auto& f: vf) boundDispatcher->add(f);
+	t=py::tuple(); // empty the args
+}
+
+void VerletCollider::getLabeledObjects(const shared_ptr<LabelMapper>& labelMapper){ if(boundDispatcher) boundDispatcher->getLabeledObjects(labelMapper); Engine::getLabeledObjects(labelMapper); }
+
+bool VerletCollider::shouldBeRemoved(const shared_ptr<Contact>& C, Scene* scene) const {
+	if(C->pA.expired() || C->pB.expired()) return true; // remove contact where constituent particles have been deleted
+	Particle::id_t idA=C->leakPA()->id, idB=C->leakPB()->id;
+	if(max(idA,idB)>=(Particle::id_t)boxes.size()) return true;
+	return !boxesOverlap(idA,idB);
+}
+
+void VerletCollider::copyBoxes(const vector<int>* ids){
+	const long n=(ids?ids->size():dem->particles->size());
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long i=0; i<n; i++){
+		const Particle::id_t id=(ids?(*ids)[i]:i);
+		const shared_ptr<Particle>& p((*dem->particles)[id]);
+		unsigned char& f(parFlags[id]);
+		f&=PAR_DIRTY;
+		if(!p || !p->shape || !p->shape->bound) continue;
+		const Bound& b(*p->shape->bound);
+		boxes[id]=AlignedBox3r(b.min,b.max);
+		f|=PAR_BOUND;
+		if(!b.min.allFinite() || !b.max.allFinite()) f|=PAR_HUGE;
+	}
+}
+
+void VerletCollider::buildLists(){
+	nListBuilds++;
+	const long nPar=boxes.size();
+	listBoxes.resize(nPar);
+	neighbours.resize(nPar);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long id=0; id<nPar; id++){
+		neighbours[id].clear();
+		if((parFlags[id]&(PAR_BOUND|PAR_HUGE))!=PAR_BOUND) continue;
+		listBoxes[id]=AlignedBox3r(boxes[id].min()-listDist*Vector3r::Ones(),boxes[id].max()+listDist*Vector3r::Ones());
+	}
+	huge.clear();
+	AlignedBox3r extent; Real maxSize=0;
+	for(long id=0; id<nPar; id++){
+		if(!(parFlags[id]&PAR_BOUND)) continue;
+		if(parFlags[id]&PAR_HUGE){ huge.push_back(id); continue; }
+		extent.extend(listBoxes[id]);
+		maxSize=max(maxSize,listBoxes[id].sizes().maxCoeff());
+	}
+	if(extent.isEmpty()) return; // no finite bounds at all
+
+	// cells at least as large as any listBox, so that overlapping listBoxes have minima in neighbouring cells
+	Real h=max(maxSize,extent.sizes().maxCoeff()*1e-6);
+	Vector3i dim;
+	while(true){
+		dim=(extent.sizes()/h).array().floor().cast<int>().matrix().cwiseMax(Vector3i::Ones());
+		if(dim.cast<Real>().prod()<=maxCells) break;
+		h*=2;
+	}
+	cellSize=h;
+	const long nCells=(long)dim.prod();
+	auto cellOf=[&](const Vector3r& x)->Vector3i{
+		Vector3i ret;
+		for(int ax:{0,1,2}) ret[ax]=(int)std::min(std::max((x[ax]-extent.min()[ax])/h,(Real)0.),(Real)(dim[ax]-1));
+		return ret;
+	};
+	auto linIx=[&](const Vector3i& ijk)->long{ return (long(ijk[0])*dim[1]+ijk[1])*dim[2]+ijk[2]; };
+
+	// counting sort of particles by cells, without locks
+	parCell.assign(nPar,-1);
+	cellStart.assign(nCells+1,0);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long id=0; id<nPar; id++){
+		if((parFlags[id]&(PAR_BOUND|PAR_HUGE))!=PAR_BOUND) continue;
+		const long c=linIx(cellOf(listBoxes[id].min()));
+		parCell[id]=c;
+		#ifdef WOO_OPENMP
+			#pragma omp atomic
+		#endif
+		cellStart[c+1]++;
+	}
+	std::partial_sum(cellStart.begin(),cellStart.end(),cellStart.begin());
+	cellIds.resize(cellStart[nCells]);
+	vector<long> cellFill(cellStart.begin(),cellStart.end()-1);
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(static)
+	#endif
+	for(long id=0; id<nPar; id++){
+		const long& c(parCell[id]);
+		if(c<0) continue;
+		long pos;
+		#ifdef WOO_OPENMP
+			#pragma omp atomic capture
+		#endif
+		pos=cellFill[c]++;
+		cellIds[pos]=id;
+	}
+
+	// neighbour lists, in both directions
+	#ifdef WOO_OPENMP
+		#pragma omp parallel for schedule(dynamic,256)
+	#endif
+	for(long id=0; id<nPar; id++){
+		if(parCell[id]<0) continue;
+		const AlignedBox3r& A(listBoxes[id]);
+		const Vector3i c=cellOf(A.min());
+		vector<Particle::id_t>& nn(neighbours[id]);
+		for(Vector3i ijk=(c-Vector3i::Ones()).cwiseMax(Vector3i::Zero()); ijk[0]<=min(c[0]+1,dim[0]-1); ijk[0]++){
+			for(ijk[1]=max(c[1]-1,0); ijk[1]<=min(c[1]+1,dim[1]-1); ijk[1]++){
+				for(ijk[2]=max(c[2]-1,0); ijk[2]<=min(c[2]+1,dim[2]-1); ijk[2]++){
+					const long lin=linIx(ijk);
+					for(long k=cellStart[lin]; k<cellStart[lin+1]; k++){
+						const Particle::id_t& id2=cellIds[k];
+						if(id2==id) continue;
+						const AlignedBox3r& B(listBoxes[id2]);
+						if((A.min().array()<=B.max().array()).all() && (A.max().array()>=B.min().array()).all()) nn.push_back(id2);
+					}
+				}
+			}
+		}
+		// the order within cells depends on thread scheduling
+		std::sort(nn.begin(),nn.end());
+	}
+}
+
+void VerletCollider::tryContact(const Particle::id_t& a, const Particle::id_t& b){
+	if(!boxesOverlap(a,b)) return;
+	const auto& pA((*dem->particles)[a]); const auto& pB((*dem->particles)[b]);
+	if(!Collider::mayCollide(dem,pA,pB)) return;
+	const shared_ptr<Contact>& C=dem->contacts->find(a,b);
+	// every pair is visited once, so this write does not race
+	if(C){ C->stepLastSeen=scene->step; return; }
+	shared_ptr<Contact> newC=woo::slab_make_shared<Contact>();
+	if(a<b){ newC->pA=pA; newC->pB=pB; }
+	else { newC->pA=pB; newC->pB=pA; }
+	newC->stepCreated=scene->step;
+	newC->stepLastSeen=scene->step;
+	#ifdef WOO_OPENMP
+		thNewContacts[omp_get_thread_num()].push_back(newC);
+	#else
+		thNewContacts[0].push_back(newC);
+	#endif
+}
+
+void VerletCollider::addNewContacts(){
+	ContactContainer& cc(*dem->contacts);
+	#if defined(WOO_OPENMP) || defined(WOO_OPENGL)
+		boost::mutex::scoped_lock lock(cc.manipMutex);
+	#endif
+	// potential contacts of which bounds got separated
+	for(auto& rr: thRemove){
+		for(const auto& C: rr) cc.removeMaybe_fast(C);
+		rr.clear();
+	}
+	size_t nNew=0;
+	for(const auto& nn: thNewContacts) nNew+=nn.size();
+	#ifdef WOO_OPENMP
+		if(!scene->deterministic && nNew>=(size_t)paraAddMin){
+			cc.beginConcurrent(nNew);
+			#pragma omp parallel
+			for(const auto& nn: thNewContacts){
+				const long sz=nn.size();
+				#pragma omp for schedule(static) nowait
+				for(long i=0; i<sz; i++) cc.addConcurrent(nn[i]);
+			}
+			cc.endConcurrent();
+			for(auto& nn: thNewContacts) nn.clear();
+			return;
+		}
+	#endif
+	if(scene->deterministic){
+		// the order in which threads found contacts depends on scheduling
+		vector<shared_ptr<Contact>> all; all.reserve(nNew);
+		for(auto& nn: thNewContacts){ all.insert(all.end(),nn.begin(),nn.end()); nn.clear(); }
+		std::sort(all.begin(),all.end(),[](const shared_ptr<Contact>& a, const shared_ptr<Contact>& b){
+			return std::make_pair(a->leakPA()->id,a->leakPB()->id)<std::make_pair(b->leakPA()->id,b->leakPB()->id);
+		});
+		for(const auto& C: all) cc.addMaybe_fast(C);
+		return;
+	}
+	for(auto& nn: thNewContacts){
+		for(const auto& C: nn) cc.addMaybe_fast(C);
+		nn.clear();
+	}
+}
+
+void VerletCollider::run(){
+	dem=static_cast<DemField*>(field.get());
+	if(scene->isPeriodic) throw std::runtime_error("VerletCollider: periodic boundaries are not supported.");
+	boundDispatcher->scene=scene;
+	boundDispatcher->field=field;
+	boundDispatcher->updateScenePtr();
+
+	// automatically initialize from min sphere size; if no spheres, disable stride
+	if(verletDist<0){
+		Real minR=Inf;
+		for(const shared_ptr<Particle>& p: *dem->particles){
+			if(!p || !p->shape || !p->shape->isA<Sphere>()) continue;
+			minR=min(p->shape->cast<Sphere>().radius,minR);
+		}
+		verletDist=isinf(minR)?0:abs(verletDist)*minR;
+	}
+	if(listDist<0) listDist=abs(listDist)*verletDist;
+
+	// with verletDist, only bounds which are not valid anymore are recomputed
+	size_t nDirty=boundDispatcher->updateBounds(*dem,verletDist,/*lazy*/verletDist>0,noBoundOk);
+	const long nPar=dem->particles->size();
+	bool rebuild=(dem->contacts->dirty || (long)boxes.size()!=nPar || (long)listBoxes.size()!=nPar);
+	dem->contacts->dirty=false;
+	if(!rebuild && nDirty==0){
+		// bounds did not change, so neither did their overlaps
+		dem->contacts->removePending(*this,scene);
+		return;
+	}
+	#ifdef WOO_OPENMP
+		const int nThreads=omp_get_max_threads();
+	#else
+		const int nThreads=1;
+	#endif
+	if((int)thNewContacts.size()!=nThreads){ thNewContacts.resize(nThreads); thRemove.resize(nThreads); }
+
+	const vector<int>& dirty(boundDispatcher->dirty);
+	if(!rebuild){
+		for(const int& id: dirty) parFlags[id]|=PAR_DIRTY;
+		const vector<unsigned char> prevFlags(parFlags);
+		copyBoxes(&dirty);
+		// lists are valid as long as updated bounds are inside their listBoxes, and particles did not change their kind
+		for(const int& id: dirty){
+			if(parFlags[id]!=prevFlags[id] || ((parFlags[id]&PAR_BOUND) && !(parFlags[id]&PAR_HUGE) && !listBoxes[id].contains(boxes[id]))){ rebuild=true; break; }
+		}
+		if(rebuild) for(const int& id: dirty) parFlags[id]&=~PAR_DIRTY;
+	}
+
+	if(rebuild){
+		/*** NEIGHBOUR LISTS REBUILD: all pairs ***/
+		boxes.resize(nPar); parFlags.assign(nPar,0);
+		copyBoxes(NULL);
+		buildLists();
+		// contacts not seen in this step will be deleted by ContactLoop
+		dem->contacts->stepColliderLastRun=scene->step;
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(dynamic,256)
+		#endif
+		for(long id=0; id<nPar; id++){
+			const unsigned char& f(parFlags[id]);
+			if(!(f&PAR_BOUND)) continue;
+			// pairs of two huge particles from the higher id
+			for(const Particle::id_t& h: huge){
+				if(h==id || ((f&PAR_HUGE) && h>id)) continue;
+				tryContact(id,h);
+			}
+			if(f&PAR_HUGE) continue;
+			for(const Particle::id_t& id2: neighbours[id]) if(id2>id) tryContact(id,id2);
+		}
+	} else {
+		/*** BOUNDS UPDATED: neighbours of updated particles only ***/
+		nUpdates++;
+		const long nD=dirty.size();
+		#ifdef WOO_OPENMP
+			#pragma omp parallel for schedule(dynamic,64)
+		#endif
+		for(long i=0; i<nD; i++){
+			const Particle::id_t id=dirty[i];
+			const unsigned char& f(parFlags[id]);
+			if(!(f&PAR_BOUND)) continue;
+			// pairs of two updated particles are handled from the lower id
+			auto visit=[&](const Particle::id_t& id2){
+				if(id2==id || ((parFlags[id2]&PAR_DIRTY) && id2<id)) return;
+				tryContact(id,id2);
+			};
+			if(f&PAR_HUGE){ for(long id2=0; id2<nPar; id2++) if(parFlags[id2]&PAR_BOUND) visit(id2); }
+			else {
+				for(const Particle::id_t& id2: neighbours[id]) visit(id2);
+				for(const Particle::id_t& h: huge) visit(h);
+			}
+			// potential contacts of which bounds don't overlap anymore
+			for(const auto& idC: (*dem->particles)[id]->contacts){
+				if(idC.second->isReal() || boxesOverlap(id,idC.first)) continue;
+				#ifdef WOO_OPENMP
+					thRemove[omp_get_thread_num()].push_back(idC.second);
+				#else
+					thRemove[0].push_back(idC.second);
+				#endif
+			}
+		}
+		for(const int& id: dirty) parFlags[id]&=~PAR_DIRTY;
+	}
+	addNewContacts();
+
+	// pending contacts of which bounds don't overlap anymore
+	dem->contacts->removePending(*this,scene);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include<woo/pkg/dem/Collision.hpp>
+
+/*
+Collider keeping per-particle neighbour (Verlet) lists.
+
+Bounds are enlarged by verletDist and recomputed lazily by BoundDispatcher, only when some node
+moved too far; when no bound was updated, the collider only processes pending contacts.
+
+Neighbour lists contain particles of which bounds, enlarged by further listDist, overlap
+(listBoxes). While every current bound stays inside its listBox, any pair of overlapping bounds
+is in the lists, hence updated bounds are only tested against neighbours of the particle.
+When some bound leaves its listBox (or particles are added/removed), the lists are rebuilt
+in a parallel cell-list pass: cells are as large as the largest listBox, particles are
+binned by the minimum of their listBox (counting sort), so that overlapping listBoxes
+are in neighbouring cells (27-stencil). Particles with infinite bounds (walls) are tested
+against all others instead of being stored in lists.
+*/
+struct VerletCollider: public Collider{
+	WOO_DECL_LOGGER;
+	bool acceptsField(Field* f) WOO_CXX11_OVERRIDE { return dynamic_cast<DemField*>(f); }
+	void run() WOO_CXX11_OVERRIDE;
+	void pyHandleCustomCtorArgs(py::tuple& t, py::dict& d) WOO_CXX11_OVERRIDE;
+	void getLabeledObjects(const shared_ptr<LabelMapper>&) WOO_CXX11_OVERRIDE;
+	void invalidatePersistentData() WOO_CXX11_OVERRIDE { boxes.clear(); listBoxes.clear(); neighbours.clear(); }
+	// predicate called from ContactContainer::removePending
+	bool shouldBeRemoved(const shared_ptr<Contact>& C, Scene* scene) const;
+
+	private:
+	DemField* dem;
+	// current bounds of all particles
+	vector<AlignedBox3r> boxes;
+	// bounds enlarged by listDist at the last list build
+	vector<AlignedBox3r> listBoxes;
+	// neighbours of each particle (both directions), without huge particles
+	vector<vector<Particle::id_t>> neighbours;
+	// particles with infinite bounds, tested against all others
+	vector<Particle::id_t> huge;
+	// PAR_BOUND for particles with bound, with PAR_HUGE for infinite ones; PAR_DIRTY is set temporarily for particles with bound updated in this step
+	enum{ PAR_BOUND=1, PAR_HUGE=2, PAR_DIRTY=4 };
+	vector<unsigned char> parFlags;
+	// cell lists (counting sort): ids in cell c are cellIds[cellStart[c]..cellStart[c+1]-1]
+	vector<long> parCell, cellStart;
+	vector<Particle::id_t> cellIds;
+	vector<vector<shared_ptr<Contact>>> thNewContacts, thRemove;
+	bool boxesOverlap(const Particle::id_t& a, const Particle::id_t& b) const {
+		const AlignedBox3r& A(boxes[a]); const AlignedBox3r& B(boxes[b]);
+		return (A.min().array()<=B.max().array()).all() && (A.max().array()>=B.min().array()).all();
+	}
+	// copy bounds of particles given (or all, if NULL) into boxes
+	void copyBoxes(const vector<int>* ids);
+	// rebuild cell lists and neighbour lists from current bounds
+	void buildLists();
+	void tryContact(const Particle::id_t& a, const Particle::id_t& b);
+	void addNewContacts();
+
+	public:
+	#define woo_dem_VerletCollider__CLASS_BASE_DOC_ATTRS_CTOR \
+		VerletCollider,Collider,ClassTrait().doc("Collider keeping per-particle neighbour (Verlet) lists, built from bounds enlarged by :obj:`listDist`; when bounds are updated (a node moved by more than :obj:`verletDist`), only neighbours of respective particles are tested, and lists are rebuilt only when some bound gets outside its enlarged box. Rebuild is a parallel cell-list pass. When no bound changes (such as in quasi-static simulations), the collider only handles pending contacts. Particles with infinite bounds are tested against all others. Periodic boundaries are not supported."), \
+		((Real,verletDist,((void)"Automatically initialized",-.05),AttrTrait<>().lenUnit(),"Length by which to enlarge particle bounds, to avoid running collider at every step. Negative value will trigger automatic computation, so that the real value will be ``|verletDist|`` × minimum spherical particle radius; if there are no spherical particles, it will be disabled.")) \
+		((Real,listDist,((void)"Relative to verletDist",-1.),AttrTrait<>().lenUnit(),"Length by which bounds are further enlarged for neighbour lists; lists are rebuilt when some bound is not inside its enlarged box anymore. Negative value is relative to :obj:`verletDist` (and is replaced by the absolute value at the first run).")) \
+		((bool,noBoundOk,false,,"Allow particles without bounding box.")) \
+		((long,maxCells,1<<21,,"Maximum number of cells for building neighbour lists; cell size is increased if needed.")) \
+		((int,paraAddMin,1000,,"Minimum number of new contacts to add them in parallel (concurrent mode of :obj:`ContactContainer`; not with :obj:`Scene.deterministic`).")) \
+		((shared_ptr<BoundDispatcher>,boundDispatcher,make_shared<BoundDispatcher>(),AttrTrait<Attr::readonly>(),":obj:`BoundDispatcher` object that is used for creating :obj:`bounds <Particle.bound>` on collider's request as necessary.")) \
+		((Real,cellSize,NaN,AttrTrait<Attr::readonly|Attr::noSave>().lenUnit(),"Cell size used in the last list build.")) \
+		((long,nListBuilds,0,AttrTrait<Attr::readonly>(),"Number of neighbour list builds.")) \
+		((long,nUpdates,0,AttrTrait<Attr::readonly>(),"Number of runs where some bounds were updated, but neighbour lists were still valid.")) \
+		, /*ctor*/ dem=NULL;
+
+	WOO_DECL__CLASS_BASE_DOC_ATTRS_CTOR(woo_dem_VerletCollider__CLASS_BASE_DOC_ATTRS_CTOR);
+};
+WOO_REGISTER_OBJECT(VerletCollider);
@@ -84,7 +84,7 @@ def Object_dump(obj,out,format='auto',fallbackFormat=None,overwrite=True,fragmen
 		elif sum([out.endswith(ext) for ext in ('.expr','expr.gz','expr.bz2')]): format='expr'
 		elif sum([out.endswith(ext) for ext in ('.pickle','pickle.gz','pickle.bz2')]): format='pickle'
 		elif sum([out.endswith(ext) for ext in ('.json','json.gz','json.bz2')]): format='json'
-		elif sum([out.endswith(ext) for ext in ('.xml','.xml.gz','.xml.bz2','.bin','.gz','.bz2')]): format='boost::serialization'
+		elif sum([out.endswith(ext) for ext in ('.xml','.xml.gz','.xml.bz2','.xml.bgz','.bin','.gz','.bz2','.bgz')]): format='boost::serialization'
 		elif fallbackFormat is not None: format=fallbackFormat
 		else: IOError("Output format not deduced for filename '%s' (and fallbackFormat not specified)"%out)
 	if format not in ('auto','html','json','expr','pickle','boost::serialization'): raise IOError("Unsupported dump format %s"%format)
@@ -405,7 +405,7 @@ def Object_load(typ,inFile,format='auto'):
 		if type==None: return obj
 		if not isinstance(obj,typ): raise TypeError('Loaded object of type '+obj.__class__.__name__+' is not a '+typ.__name__)
 		return obj
-	validFormats=('auto','boost::serialization','expr','pickle','json')
+	validFormats=('auto','boost::serialization','expr','pickle','json','columnar')
 	if format not in validFormats: raise ValueError('format must be one of '+', '.join(validFormats)+'.')
 	if format=='auto':
 		format=None
@@ -430,6 +430,8 @@ def Object_load(typ,inFile,format='auto'):
 			format='boost::serialization'
 		elif head.startswith(b'##woo-expression##'):
 			format='expr'
+		elif head.startswith(b'##woo-columnar##') or head.startswith(b'##woo-col-delta#'):
+			format='columnar'
 		else:
 			# test pickling by trying to load
 			try: return typeChecked(pickle.load(open(inFile,'rb')),typ) # open again to seek to the beginning
@@ -451,6 +453,9 @@ def Object_load(typ,inFile,format='auto'):
 		return typeChecked(pickle.load(open(inFile,'rb')),typ)
 	elif format=='json':
 		return typeChecked(WooJSONDecoder().decode(codecs.open(inFile,'rb','utf-8').read()),typ)
+	elif format=='columnar':
+		import woo.dem
+		return typeChecked(woo.dem.ColumnarCheckpoint.load(str(inFile)),typ)
 	assert False
 
 
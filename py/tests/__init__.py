@@ -20,6 +20,7 @@ from . import shapepack
 from . import tetra
 from . import volumetric
 from . import demfield
+from . import collider
 # this is ugly, but automatic
 allTests=[m for m in dir() if type(eval(m))==types.ModuleType and eval(m).__name__.startswith('woo.tests')]
 # should the above break, do it manually (but keep the imports above):
@@ -0,0 +1,195 @@
+'''
+Test collision detection (colliders and bounds).
+'''
+import woo
+import unittest
+from woo.core import *
+from woo.dem import *
+from minieigen import *
+
+class TestBounds(unittest.TestCase):
+	def testLazyBounds(self):
+		'Collider: only bounds of particles moving beyond verletDist are recomputed'
+		m=FrictMat(young=1e6,density=1e3)
+		S=Scene(fields=[DemField(par=[Sphere.make((0,0,0),.5,mat=m,fixed=True),Sphere.make((2,0,0),.5,mat=m)])],engines=DemField.minimalEngines(verletDist=.1,dynDtPeriod=0),dt=1e-3)
+		S.dem.par[1].vel=(-10,0,0)
+		S.one()
+		self.assertEqual(S.lab.collider.boundDispatcher.dirty,[0,1])
+		dirty=set()
+		for i in range(110):
+			S.one()
+			dirty|=set(S.lab.collider.boundDispatcher.dirty)
+		# the fixed sphere keeps its bound from the first step
+		self.assertEqual(dirty,set([1]))
+		self.assertEqual(S.dem.par[0].shape.bound.nodeLastPos,[Vector3(0,0,0)])
+		# spheres overlap now, and the contact was found
+		self.assert_(S.dem.con.existsReal(0,1))
+
+class TestInitSort(unittest.TestCase):
+	def testRadixSort(self):
+		'Collider: initial radix sort and parallel sweep find the same contacts as comparison sort (periodic and aperiodic)'
+		import random
+		random.seed(1)
+		pos=[Vector3(random.uniform(0,3),random.uniform(0,3),random.uniform(0,3)) for i in range(300)]
+		for peri in False,True:
+			conIds=[]
+			for radix in True,False:
+				m=FrictMat(young=1e6,density=1e3)
+				S=Scene(fields=[DemField(par=[Sphere.make(p,.2,mat=m) for p in pos])],engines=DemField.minimalEngines(),dt=1e-5,periodic=peri)
+				if peri: S.cell.setBox((3,3,3))
+				S.lab.collider.radixSort=radix
+				S.lab.collider.paraInitSweep=radix
+				S.one()
+				self.assertEqual(S.lab.collider.numReinit,1)
+				conIds.append(sorted([tuple(sorted(c.ids)) for c in S.dem.con]))
+			self.assert_(len(conIds[0])>0)
+			self.assertEqual(conIds[0],conIds[1])
+
+class TestIncInsert(unittest.TestCase):
+	def testIncInsert(self):
+		'Collider: particles added and removed are merged into bound arrays without the initial sort'
+		import random
+		random.seed(2)
+		m=FrictMat(young=1e6,density=1e3)
+		def mkSphere(): return Sphere.make((random.uniform(0,3),random.uniform(0,3),random.uniform(0,3)),.2,mat=m,fixed=True)
+		def overlapping(S):
+			ret=set()
+			for p1 in S.dem.par:
+				for p2 in S.dem.par:
+					if p1.id<p2.id and (p1.pos-p2.pos).norm()<p1.shape.radius+p2.shape.radius: ret.add((p1.id,p2.id))
+			return ret
+		def realContacts(S): return set([tuple(sorted(c.ids)) for c in S.dem.con if c.real])
+		S=Scene(fields=[DemField(par=[mkSphere() for i in range(300)])],engines=DemField.minimalEngines(),dt=1e-5)
+		S.one()
+		self.assertEqual(S.lab.collider.numReinit,1)
+		# append many particles
+		for i in range(300): S.dem.par.add(mkSphere())
+		S.one()
+		self.assertEqual(realContacts(S),overlapping(S))
+		# remove from the middle and from the end, then re-use freed ids
+		for id in list(range(100,150))+list(range(550,600)): S.dem.par.remove(id)
+		S.one()
+		self.assertEqual(realContacts(S),overlapping(S))
+		for i in range(50): S.dem.par.add(mkSphere())
+		S.one()
+		self.assertEqual(realContacts(S),overlapping(S))
+		self.assertEqual(S.lab.collider.numReinit,1)
+		self.assert_(S.lab.collider.numIncInsert>=2)
+
+class TestParaPeri(unittest.TestCase):
+	def testParallelSort(self):
+		'Collider: parallel periodic insertion sort finds the same contacts as the sequential one'
+		import random
+		random.seed(3)
+		pos=[Vector3(random.uniform(0,3),random.uniform(0,3),random.uniform(0,3)) for i in range(800)]
+		vel=[Vector3(random.uniform(-20,20),random.uniform(-20,20),random.uniform(-20,20)) for i in range(800)]
+		conIds=[]
+		for para in True,False:
+			m=FrictMat(young=1e6,density=1e3)
+			S=Scene(fields=[DemField(par=[Sphere.make(p,.1,mat=m,fixed=True) for p in pos])],engines=DemField.minimalEngines(dynDtPeriod=0),dt=1e-3,periodic=True)
+			S.cell.setBox((3,3,3))
+			for p,v in zip(S.dem.par,vel): p.vel=v
+			S.lab.collider.paraPeri=para
+			# small chunks, so that the sort is chunked even with one thread
+			S.lab.collider.ompTuneSort=(2,0,0)
+			# particles cross cell boundaries many times
+			S.run(200,True)
+			conIds.append(sorted([tuple(sorted(c.ids)) for c in S.dem.con if c.real]))
+		self.assert_(len(conIds[0])>0)
+		self.assertEqual(conIds[0],conIds[1])
+
+class TestOmpTuneSort(unittest.TestCase):
+	def testAutoTune(self):
+		'Collider: sort timing is measured, ompTuneSort is tuned automatically'
+		import random
+		random.seed(4)
+		m=FrictMat(young=1e6,density=1e3)
+		S=Scene(fields=[DemField(par=[Sphere.make((random.uniform(0,3),random.uniform(0,3),random.uniform(0,3)),.05,mat=m) for i in range(2000)])],engines=DemField.minimalEngines(verletDist=0,dynDtPeriod=0),dt=1e-4)
+		S.lab.collider.ompTuneWindow=2
+		S.run(30,True)
+		c=S.lab.collider
+		self.assert_(c.sortPassTime>0)
+		self.assert_(min(c.sortPasses)>=1)
+		if 'openmp' in woo.config.features:
+			# tuning finished, with at least one candidate measured
+			self.assert_(len(c.ompTuneTimings)>0)
+			self.assertEqual(c.ompTuneSort[0],int(min(c.ompTuneTimings,key=lambda t: t[1])[0]))
+	def testUserSet(self):
+		'Collider: ompTuneSort set by the user is not changed by tuning'
+		m=FrictMat(young=1e6,density=1e3)
+		S=Scene(fields=[DemField(par=[Sphere.make((.1*i,0,0),.05,mat=m) for i in range(500)])],engines=DemField.minimalEngines(verletDist=0,dynDtPeriod=0),dt=1e-4)
+		S.lab.collider.ompTuneWindow=2
+		S.lab.collider.ompTuneSort=(3,0,0)
+		S.run(30,True)
+		self.assertEqual(S.lab.collider.ompTuneSort,Vector3i(3,0,0))
+		self.assertEqual(len(S.lab.collider.ompTuneTimings),0)
+
+class TestHierGridCollider(unittest.TestCase):
+	def testContacts(self):
+		'HierGridCollider: finds all contacts with wide size distribution and walls'
+		import random
+		random.seed(3)
+		m=FrictMat(young=1e6,density=1e3)
+		par=[Sphere.make((random.uniform(0,2),random.uniform(0,2),random.uniform(0,2)),random.choice([.01,.03,.1,.5]),mat=m,fixed=True) for i in range(400)]
+		S=Scene(fields=[DemField(par=par+[Wall.make(.2,axis=2,sense=0,mat=m)])],engines=DemField.minimalEngines(grid='hier'),dt=1e-5)
+		S.one()
+		coll=S.lab.collider
+		self.assert_(isinstance(coll,HierGridCollider))
+		self.assert_(len(coll.grids)>1)
+		self.assertEqual(coll.levelCount[-1],1) # the wall
+		expected=set()
+		for p1 in S.dem.par:
+			for p2 in S.dem.par:
+				if not p1.id<p2.id: continue
+				if isinstance(p2.shape,Wall):
+					if abs(p1.pos[2]-.2)<p1.shape.radius: expected.add((p1.id,p2.id))
+				elif (p1.pos-p2.pos).norm()<p1.shape.radius+p2.shape.radius: expected.add((p1.id,p2.id))
+		self.assertEqual(set([tuple(sorted(c.ids)) for c in S.dem.con if c.real]),expected)
+		# nothing moves, the collider does not run again
+		S.run(5,True)
+		self.assertEqual(coll.nFullRuns,1)
+	def testDomainGrow(self):
+		'HierGridCollider: domain grows when particles leave it'
+		m=FrictMat(young=1e6,density=1e3)
+		S=Scene(fields=[DemField(par=[Sphere.make((.2*i,0,0),.1,mat=m,fixed=True) for i in range(5)])],engines=DemField.minimalEngines(grid='hier'),dt=1e-5)
+		S.one()
+		coll=S.lab.collider
+		d0=coll.domain
+		# two touching spheres far away
+		S.dem.par.add([Sphere.make((10,10,10),.1,mat=m,fixed=True),Sphere.make((10,10,10.15),.1,mat=m,fixed=True)])
+		S.one()
+		self.assert_(coll.domain.contains(d0) and coll.domain.contains(Vector3(10,10,10.25)))
+		self.assert_(S.dem.con.exists(5,6))
+		# with domainGrow negative, the domain is kept
+		coll.domainGrow=-1; d1=coll.domain
+		S.dem.par.add([Sphere.make((-20,0,0),.1,mat=m,fixed=True),Sphere.make((-20,0,.15),.1,mat=m,fixed=True)])
+		S.one()
+		self.assertEqual((coll.domain.min,coll.domain.max),(d1.min,d1.max))
+		self.assert_(S.dem.con.exists(7,8))
+
+class TestVerletCollider(unittest.TestCase):
+	def testContacts(self):
+		'VerletCollider: neighbour lists find all contacts of moving particles, and are not rebuilt at every update'
+		import random
+		random.seed(4)
+		m=FrictMat(young=1e6,density=1e3)
+		par=[Sphere.make((random.uniform(0,3),random.uniform(0,3),random.uniform(0,3)),.1,mat=m) for i in range(500)]
+		for p in par: p.vel=(random.uniform(-1,1),random.uniform(-1,1),random.uniform(-1,1))
+		engines=DemField.minimalEngines(dynDtPeriod=0)
+		engines[1]=VerletCollider([Bo1_Sphere_Aabb(),Bo1_Wall_Aabb()],label='collider')
+		S=Scene(fields=[DemField(par=par+[Wall.make(0,axis=2,sense=1,mat=m)])],engines=engines,dt=1e-4)
+		def expected():
+			ret=set()
+			for p1 in S.dem.par:
+				for p2 in S.dem.par:
+					if not p1.id<p2.id: continue
+					if isinstance(p2.shape,Wall):
+						if abs(p1.pos[2])<p1.shape.radius: ret.add((p1.id,p2.id))
+					elif (p1.pos-p2.pos).norm()<p1.shape.radius+p2.shape.radius: ret.add((p1.id,p2.id))
+			return ret
+		for i in range(4):
+			S.run(100,True)
+			self.assertEqual(set([tuple(sorted(c.ids)) for c in S.dem.con if c.real]),expected())
+		coll=S.lab.collider
+		self.assert_(coll.nUpdates>0)
+		self.assert_(coll.nListBuilds<coll.nUpdates)
@@ -21,6 +21,23 @@ class TestDemField(unittest.TestCase):
 		d=DemData(blocked='xyzXYZ',vel=(1,1,1),mass=1)
 		self.assert_(d.guessMoving()==True)  # velocity assigned, move
 
+class TestParticleContacts(unittest.TestCase):
+	def testManyContacts(self):
+		'DEM: per-particle contact index with many contacts (hashed mode)'
+		m=FrictMat(young=1e6,density=1e3)
+		N=50
+		S=Scene(fields=[DemField(par=[Wall.make(0,axis=2,sense=1,mat=m)]+[Sphere.make((i,0,.45),.5,mat=m) for i in range(N)])],engines=DemField.minimalEngines(),dt=1e-6)
+		S.one()
+		w=S.dem.par[0]
+		self.assertEqual(sorted(w.allContacts.keys()),list(range(1,N+1)))
+		for i in range(1,N+1,2): S.dem.par.remove(i)
+		self.assertEqual(sorted(w.allContacts.keys()),list(range(2,N+1,2)))
+		for i in range(2,N+1,2): self.assert_(S.dem.con.exists(0,i) and S.dem.par[i].allContacts.keys()==[0])
+	def testBench(self):
+		'DEM: ContactContainer.benchParticleIndex runs'
+		r=ContactContainer.benchParticleIndex(coordNums=[4,20],nPar=100,nRep=1)
+		self.assertEqual([d['coordNum'] for d in r],[4,20])
+
 class TestContactLoop(unittest.TestCase):
 	def testUpdatePhys(self):
 		'DEM: ContactLoop.updatePhys: never, always, once'
@@ -48,6 +65,121 @@ class TestContactLoop(unittest.TestCase):
 			else:
 				self.assert_(S.lab.contactLoop.updatePhys=='never') # once changed to never, or just never
 				self.assertEqual(kn1,c.phys.kn)
+	def testBucketing(self):
+		'DEM: ContactLoop.bucketing gives the same results as full dispatch'
+		def run(bucketing,updatePhys='never'):
+			m=FrictMat(young=1e6,density=1e3)
+			S=Scene(fields=[DemField(gravity=(0,0,-10),par=[Wall.make(-.5,axis=2,sense=1,mat=m)]+[Sphere.make((.1*i,0,i*.9),.5,mat=m) for i in range(5)])],engines=DemField.minimalEngines(damping=.3),dt=1e-4)
+			S.lab.contactLoop.bucketing=bucketing
+			S.lab.contactLoop.updatePhys=updatePhys
+			S.deterministic=True
+			S.run(300,True)
+			return [(p.pos,p.vel) for p in S.dem.par],S
+		ref,S0=run(False)
+		bucketed,S1=run(True)
+		self.assertEqual(ref,bucketed)
+		# buckets are kept (and phys updated within them) with updatePhys
+		self.assertEqual(run(False,'always')[0],run(True,'always')[0])
+		bb=S1.lab.contactLoop.buckets
+		ss=[b for b in bb if b['cg']=='Cg2_Sphere_Sphere_L6Geom']
+		self.assert_(len(ss)==1 and ss[0]['specialized'] and ss[0]['num']>0)
+		self.assert_([b for b in bb if b['cg']=='Cg2_Wall_Sphere_L6Geom' and not b['specialized']])
+	def testBucketingSwapped(self):
+		'DEM: ContactLoop.bucketing with materials in swapped order gives the same results as full dispatch'
+		def run(bucketing):
+			# alternating materials, hence contacts with IceMat as particle A (swapped for the functor) and as particle B
+			mats=[IceMat(young=1e6,density=1e3),FrictMat(young=3e6,density=1e3)]
+			par=[Sphere.make((0,0,0),.5,mat=mats[0],fixed=True)]
+			for i in range(1,6):
+				r=(.3 if i%2 else .4); z=par[-1].pos[2]+par[-1].shape.radius+r-.01 # slightly overlapping
+				par.append(Sphere.make((0,0,z),r,mat=mats[i%2]))
+			S=Scene(fields=[DemField(gravity=(0,0,-10),par=par)],engines=DemField.minimalEngines(damping=.3,cp2=WooTestCp2_FrictMat_IceMat()),dt=1e-4)
+			S.lab.contactLoop.bucketing=bucketing
+			S.lab.contactLoop.updatePhys='always'
+			S.deterministic=True
+			S.run(300,True)
+			return [(p.pos,p.vel) for p in S.dem.par],sorted([(c.ids,c.phys.kn) for c in S.dem.con if c.real]),S
+		ref,refKn,S0=run(False)
+		bucketed,bucketedKn,S1=run(True)
+		self.assert_(len(refKn)>=4)
+		self.assertEqual(refKn,bucketedKn)
+		self.assertEqual(ref,bucketed)
+	def testDeterministicForces(self):
+		'DEM: ContactLoop with Scene.deterministic: reproducible and consistent with non-deterministic forces'
+		def run(det):
+			m=FrictMat(young=1e6,density=1e3)
+			# the wall has more than 16 contacts, exercising the hashed per-particle contact index
+			S=Scene(fields=[DemField(gravity=(0,0,-10),par=[Wall.make(-.5,axis=2,sense=1,mat=m)]+[Sphere.make((i,j,.05*(i+j)),.5,mat=m) for i in range(5) for j in range(5)])],engines=DemField.minimalEngines(damping=.3),dt=1e-4)
+			S.deterministic=det
+			S.run(200,True)
+			return [p.pos for p in S.dem.par]
+		d1,d2,nd=run(True),run(True),run(False)
+		self.assertEqual(d1,d2)
+		for a,b in zip(d1,nd): self.assertAlmostEqual((a-b).norm(),0,delta=1e-9)
+	def testThreadForces(self):
+		'DEM: ContactLoop.threadForces gives the same results as locking, also when particles are removed'
+		def run(threadForces):
+			m=FrictMat(young=1e6,density=1e3)
+			S=Scene(fields=[DemField(gravity=(0,0,-10),par=[Wall.make(-.5,axis=2,sense=1,mat=m)]+[Sphere.make((i,j,.05*(i+j)),.5,mat=m) for i in range(4) for j in range(4)])],engines=DemField.minimalEngines(damping=.3),dt=1e-4)
+			S.lab.contactLoop.threadForces=threadForces
+			S.run(100,True)
+			# changes DemData.linIx of the last node, with forces still pending
+			S.dem.par.remove(3)
+			S.run(100,True)
+			return [p.pos for p in S.dem.par]
+		for a,b in zip(run(False),run(True)): self.assertAlmostEqual((a-b).norm(),0,delta=1e-9)
+	def testThreadForcesGrow(self):
+		'DEM: ContactLoop.threadForces with nodes added between steps (buffers grow after being shrunk; run with more than one thread to check per-thread buffers)'
+		def run(threadForces):
+			m=FrictMat(young=1e6,density=1e3)
+			S=Scene(fields=[DemField(gravity=(0,0,-10),par=[Wall.make(-.5,axis=2,sense=1,mat=m)]+[Sphere.make((i,j,.05*(i+j)),.5,mat=m) for i in range(4) for j in range(4)])],engines=DemField.minimalEngines(damping=.3),dt=1e-4)
+			S.lab.contactLoop.threadForces=threadForces
+			S.run(50,True)
+			# shrinks the buffers
+			S.dem.par.remove(3)
+			S.run(50,True)
+			# grows the buffers by many cache lines, several times
+			for z in (1.,2.,3.):
+				S.dem.par.add([Sphere.make((i,j,z+.05*(i+j)),.5,mat=m) for i in range(4) for j in range(4)],nodes=True)
+				S.run(50,True)
+			return [p.pos for p in S.dem.par]
+		ref,tf=run(False),run(True)
+		self.assertEqual(len(ref),len(tf))
+		for a,b in zip(ref,tf): self.assertAlmostEqual((a-b).norm(),0,delta=1e-9)
+	def testStress(self):
+		'DEM: ContactLoop.evalStress sums contributions of all contacts (parallel and deterministic)'
+		for det in False,True:
+			m=FrictMat(young=1e6,density=1e3)
+			S=Scene(fields=[DemField(par=[Sphere.make((.9*i,.9*j,.9*k),.5,mat=m) for i in range(3) for j in range(3) for k in range(3)])],engines=DemField.minimalEngines(),dt=1e-5,periodic=True)
+			S.cell.setBox((2.7,2.7,2.7))
+			S.lab.contactLoop.evalStress=True
+			S.deterministic=det
+			S.run(2,True)
+			ref=Matrix3.Zero
+			for c in S.dem.con:
+				if not c.real: continue
+				ref+=(c.geom.node.ori*c.phys.force).outer(c.dPos())
+			ref/=S.cell.volume
+			self.assert_(S.dem.con.countReal()>0)
+			self.assertAlmostEqual((S.lab.contactLoop.stress-ref).norm(),0,delta=1e-9*ref.norm())
+
+	def testSpatialReorder(self):
+		'DEM: SpatialReorder keeps linIx consistent and does not change the simulation'
+		import random
+		def run(reorder):
+			random.seed(1)
+			m=FrictMat(young=1e6,density=1e3)
+			S=Scene(fields=[DemField(gravity=(0,0,-10),par=[Wall.make(-.5,axis=2,sense=1,mat=m)]+[Sphere.make((random.uniform(0,5),random.uniform(0,5),random.uniform(0,2)),.4,mat=m) for i in range(60)])],engines=DemField.minimalEngines(damping=.3),dt=1e-4)
+			if reorder: S.engines=S.engines+[SpatialReorder(stepPeriod=20,label='reorder')]
+			S.run(200,True)
+			return [p.pos for p in S.dem.par],S
+		ref,S0=run(False)
+		reo,S=run(True)
+		self.assert_(S.lab.reorder.nDone>=9)
+		self.assertEqual([n.dem.linIx for n in S.dem.nodes],list(range(len(S.dem.nodes))))
+		self.assertEqual([c.linIx for c in S.dem.con],list(range(len(S.dem.con))))
+		self.assertEqual(len(S.dem.nodes),len(S0.dem.nodes))
+		for a,b in zip(ref,reo): self.assertAlmostEqual((a-b).norm(),0,delta=1e-9)
 
 
 
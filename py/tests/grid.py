@@ -68,6 +68,26 @@ class TestGridStore(unittest.TestCase):
 			self.assert_(g12[c4]==[])
 
 
+	def testCsr(self):
+		'Grid: storage: CSR mode, sorted cells and complements'
+		g1=woo.dem.GridStore(gridSize=(3,3,3),csr=True)
+		g2=woo.dem.GridStore(gridSize=(3,3,3),csr=True)
+		c1,c2,c3=(1,1,1),(2,2,2),(2,1,2)
+		for i in (5,0,3,1): g1.append(c1,i)
+		for i in (3,2,5): g2.append(c1,i)
+		for i in (7,6): g1.append(c2,i)
+		g2.append(c3,4)
+		self.assert_(g1[c1]==[0,1,3,5])
+		self.assert_(g1.size(c2)==2 and g1.size(c3)==0)
+		self.assertRaises(RuntimeError,lambda: g1.__delitem__(c1))
+		# csr and non-csr grids are not compatible
+		self.assertRaises(RuntimeError,lambda: g1.complements(woo.dem.GridStore(gridSize=(3,3,3))))
+		g12,g21=g1.complements(g2)
+		self.assert_(g12[c1]==[0,1])
+		self.assert_(g21[c1]==[2])
+		self.assert_(g12[c2]==[6,7] and g21[c2]==[])
+		self.assert_(g12[c3]==[] and g21[c3]==[4])
+
 class TestGridColliderBasics(unittest.TestCase):
 	def testParams(self):
 		'GridCollider: used-definable parameters'
@@ -81,3 +101,28 @@ class TestGridColliderBasics(unittest.TestCase):
 		self.assertRaises(RuntimeError,lambda: setattr(gc,'domain',((0,0,0),(0,0,0))))
 		self.assertRaises(RuntimeError,lambda: setattr(gc,'domain',((0,0,0),(-1,-1,-1))))
 		
+
+class TestGridColliderPeri(unittest.TestCase):
+	def testShearedContacts(self):
+		'GridCollider: contacts and cellDist in sheared periodic cell'
+		import random
+		from woo.dem import Sphere,FrictMat,DemField,GridCollider
+		from woo.core import Scene
+		random.seed(5)
+		m=FrictMat(young=1e6,density=1e3)
+		S=Scene(fields=[DemField(par=[Sphere.make((random.uniform(0,1),random.uniform(0,1),random.uniform(0,1)),random.uniform(.04,.08),mat=m,fixed=True) for i in range(300)])],engines=DemField.minimalEngines(grid=True,verletDist=.01),dt=1e-5,periodic=True)
+		S.cell.hSize=Matrix3(1,.2,0, 0,1,0, 0,0,1)
+		S.lab.collider.minCellSize=.2
+		self.assert_(isinstance(S.lab.collider,GridCollider))
+		S.one()
+		self.assert_(S.lab.collider.dim==Vector3i(5,5,5))
+		expected={}
+		size=S.cell.size
+		for p1 in S.dem.par:
+			for p2 in S.dem.par:
+				if not p1.id<p2.id: continue
+				dU=S.cell.unshearPt(p2.pos-p1.pos)
+				cellDist=Vector3i(*[-int(round(dU[ax]/size[ax])) for ax in (0,1,2)])
+				if (p2.pos+S.cell.hSize*Vector3(*cellDist)-p1.pos).norm()<p1.shape.radius+p2.shape.radius: expected[(p1.id,p2.id)]=cellDist
+		self.assert_(any(cd!=Vector3i.Zero for cd in expected.values()))
+		self.assertEqual(dict([(tuple(sorted(c.ids)),c.cellDist) for c in S.dem.con if c.real]),expected)
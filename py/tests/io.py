@@ -75,6 +75,21 @@ class TestFormatsAndDetection(unittest.TestCase):
 	def testBinGz(self):
 		'IO: binary save/load (gzip compressed) & format detection'
 		self.tryDumpLoad(ext='.bin.gz')
+	def testBinBgz(self):
+		'IO: binary with block-parallel gzip'
+		self.tryDumpLoad(ext='.bin.bgz')
+	def testBgzLarge(self):
+		'IO: block-parallel gzip of data spanning many blocks'
+		S=woo.master.scene
+		for i in range(2000): S.dem.par.add(utils.sphere((i,0,0),radius=.5))
+		out=woo.master.tmpFilename()+'.bin.bgz'
+		S.save(out)
+		import gzip
+		# readable by gzip, as all members are standard gzip
+		self.assert_(len(gzip.open(out,'rb').read())>1<<18)
+		S2=Object.load(out)
+		self.assert_(len(S2.dem.par)==len(S.dem.par))
+		self.assert_(S2.dem.par[-1].pos==S.dem.par[-1].pos)
 	def testInvalidFormat(self):
 		'IO: invalid formats rejected'
 		self.assertRaises(IOError,lambda: woo.master.scene.dem.par[0].dumps(format='bogus'))
@@ -143,3 +158,158 @@ class TestArraySerialization(unittest.TestCase):
 		self.assert_(t1.arr3d==[[[0.0, 1.0], [2.0, 3.0]], [[4.0, 5.0], [6.0, 7.0]]])
 
 		
+
+class TestColumnarCheckpoint(unittest.TestCase):
+	def setUp(self):
+		woo.master.scene=S=Scene(fields=[DemField(gravity=(0,0,-10))],dtSafety=.9)
+		S.engines=utils.defaultEngines(damping=.4)
+		mat=utils.defaultMaterial()
+		for i in range(20): S.dem.par.add(utils.sphere((0,0,1.9*i),radius=1,mat=mat))
+		S.dem.par.add(utils.wall(-1,axis=2,sense=1,mat=mat))
+		S.dem.collectNodes()
+		S.run(200,True)
+		self.S=S
+	def testRoundTrip(self):
+		'IO: columnar checkpoint preserves particles and contacts'
+		S=self.S
+		nPar,nNodes,nCon=len(S.dem.par),len(S.dem.nodes),len(S.dem.con)
+		out=woo.master.tmpFilename()+'.wooc'
+		st=woo.dem.ColumnarCheckpoint.save(S,out)
+		self.assert_(S.lastSave==out)
+		self.assert_(woo.dem.ColumnarCheckpoint.isColumnar(out))
+		# spheres were stored in columns, only the wall went to boost::serialization
+		self.assertEqual((st['parColumnar'],st['parType'],st['parShared']),(nPar-1,1,0))
+		self.assert_(st['conColumnar']+st['conType']+st['conShared']==nCon and st['conShared']==0)
+		secs=dict([(s['name'],s) for s in woo.dem.ColumnarCheckpoint.sections(out)])
+		self.assert_(secs['f0.par.id']['count']==nPar-1)
+		self.assert_(secs['f0.node.pos']['count']==nPar-1 and secs['f0.nodes.rest']['count']==nNodes-(nPar-1))
+		self.assert_(secs['f0.con.linIx']['count']+secs['f0.con.rest']['count']==nCon and secs['f0.con.linIx']['count']>0)
+		# geometry and physics are stored for real contacts only
+		self.assert_(secs['f0.geom.pos']['count']==secs['f0.phys.force']['count']==len([c for c in S.dem.con if c.real]))
+		# the original scene is intact after saving
+		self.assert_(len(S.dem.par)==nPar and len(S.dem.nodes)==nNodes and len(S.dem.con)==nCon)
+		self.assert_(all(p is not None for p in S.dem.par))
+		S2=Object.load(out)
+		self.assert_(isinstance(S2,Scene))
+		self.assert_(len(S2.dem.par)==len(S.dem.par))
+		self.assert_(len(S2.dem.nodes)==len(S.dem.nodes))
+		for p,p2 in zip(S.dem.par,S2.dem.par):
+			self.assert_(type(p.shape)==type(p2.shape))
+			self.assert_(p.pos==p2.pos)
+			self.assert_(p.vel==p2.vel)
+			self.assert_(p.material.id==p2.material.id)
+		# shared material remains shared
+		self.assert_(S2.dem.par[0].material is S2.dem.par[1].material)
+		self.assert_(len(S2.dem.con)==len(S.dem.con) and len(S.dem.con)>0)
+		for c in S.dem.con:
+			c2=S2.dem.con[c.id1,c.id2]
+			self.assert_(c2.phys.force==c.phys.force)
+			self.assert_(c2.geom.uN==c.geom.uN)
+		# the loaded scene keeps running
+		S2.run(10,True)
+	def testShared(self):
+		'IO: columnar checkpoint stores particles referenced from elsewhere with boost::serialization, and reports them'
+		S=self.S
+		nPar=len(S.dem.par)
+		p=S.dem.par[3] # keeps a reference
+		out=woo.master.tmpFilename()+'.wooc'
+		st=woo.dem.ColumnarCheckpoint.save(S,out)
+		self.assertEqual((st['parColumnar'],st['parType'],st['parShared']),(nPar-2,1,1))
+		secs=dict([(s['name'],s) for s in woo.dem.ColumnarCheckpoint.sections(out)])
+		self.assert_(secs['f0.par.id']['count']==nPar-2)
+		S2=Object.load(out)
+		self.assert_([q.pos for q in S2.dem.par]==[q.pos for q in S.dem.par])
+		del p
+		st=woo.dem.ColumnarCheckpoint.save(S,out)
+		self.assertEqual(st['parShared'],0)
+	def testRunning(self):
+		'IO: columnar checkpoint refuses to save scene running in the background'
+		S=self.S
+		S.run()
+		try: self.assertRaises(RuntimeError,lambda: woo.dem.ColumnarCheckpoint.save(S,woo.master.tmpFilename()+'.wooc'))
+		finally:
+			S.stop(); S.wait()
+	def testMmap(self):
+		'IO: columnar checkpoint loaded with and without mmap'
+		out=woo.master.tmpFilename()+'.wooc'
+		woo.dem.ColumnarCheckpoint.save(self.S,out)
+		S1,S2=woo.dem.ColumnarCheckpoint.load(out,mmap=True),woo.dem.ColumnarCheckpoint.load(out,mmap=False)
+		self.assert_([p.pos for p in S1.dem.par]==[p.pos for p in S2.dem.par])
+		self.assert_(len(S1.dem.con)==len(S2.dem.con))
+		# loaded objects don't depend on the mapping anymore
+		import os; os.remove(out)
+		S1.run(10,True)
+	def testDelta(self):
+		'IO: columnar delta checkpoint and replay'
+		S=self.S
+		# static particles, of which state does not change
+		for i in range(500): S.dem.par.add(utils.sphere((10+3*i,50,0),radius=1,fixed=True))
+		base=woo.master.tmpFilename()+'.wooc'
+		woo.dem.ColumnarCheckpoint.save(S,base)
+		S.run(20,True)
+		delta=woo.master.tmpFilename()+'.wooc'
+		woo.dem.ColumnarCheckpoint.saveDelta(S,base,delta)
+		full=woo.master.tmpFilename()+'.wooc'
+		woo.dem.ColumnarCheckpoint.save(S,full)
+		import os
+		self.assert_(os.path.getsize(delta)<os.path.getsize(full))
+		self.assert_(woo.dem.ColumnarCheckpoint.isColumnar(delta))
+		S2=Object.load(delta)
+		self.assert_(S2.step==S.step)
+		self.assert_([p.pos for p in S2.dem.par]==[p.pos for p in S.dem.par])
+		self.assert_(len(S2.dem.con)==len(S.dem.con))
+		# replayed file is a full checkpoint of the same state
+		replayed=woo.master.tmpFilename()+'.wooc'
+		woo.dem.ColumnarCheckpoint.replay(delta,replayed)
+		self.assert_(open(replayed,'rb').read(16)==b'##woo-columnar##')
+		S3=Object.load(replayed)
+		self.assert_([p.pos for p in S3.dem.par]==[p.pos for p in S.dem.par])
+		# modified base is detected
+		woo.dem.ColumnarCheckpoint.save(S,base)
+		self.assertRaises(RuntimeError,lambda: Object.load(delta))
+	def testCompressed(self):
+		'IO: columnar checkpoint with compression'
+		out=woo.master.tmpFilename()+'.wooc.gz'
+		woo.dem.ColumnarCheckpoint.save(self.S,out)
+		S2=Object.load(out)
+		self.assert_(len(S2.dem.par)==len(self.S.dem.par))
+		self.assert_(S2.dem.par[5].pos==self.S.dem.par[5].pos)
+
+class TestCheckpointSaver(unittest.TestCase):
+	def setUp(self):
+		woo.master.scene=S=Scene(fields=[DemField(gravity=(0,0,-10))],dtSafety=.9)
+		S.engines=utils.defaultEngines(damping=.4)
+		for i in range(10): S.dem.par.add(utils.sphere((0,0,1.9*i),radius=1))
+		S.dem.par.add(utils.wall(-1,axis=2,sense=1))
+		S.dem.collectNodes()
+		self.S=S
+	def tryFormat(self,columnar,ext):
+		S=self.S
+		prefix=woo.master.tmpFilename()
+		S.engines=S.engines+[CheckpointSaver(stepPeriod=20,nDo=3,out=prefix+'-{step}'+ext,columnar=columnar,wait=True,label='ckpt')]
+		S.run(60,True)
+		S.lab.ckpt.flush()
+		self.assert_(S.lab.ckpt.nSaved==3 and S.lab.ckpt.nSkipped==0)
+		self.assert_(S.lab.ckpt.pending==0)
+		self.assert_(S.lab.ckpt.lastOut==prefix+'-40'+ext)
+		S2=Object.load(S.lab.ckpt.lastOut)
+		self.assert_(S2.step==40)
+		self.assert_(len(S2.dem.par)==len(S.dem.par))
+	def testColumnar(self):
+		'IO: CheckpointSaver writes columnar checkpoints in background'
+		self.tryFormat(True,'.wooc')
+	def testBoost(self):
+		'IO: CheckpointSaver writes boost::serialization checkpoints in background'
+		self.tryFormat(False,'.bin.gz')
+	def testDelta(self):
+		'IO: CheckpointSaver writes delta checkpoints between full ones'
+		S=self.S
+		prefix=woo.master.tmpFilename()
+		S.engines=S.engines+[CheckpointSaver(stepPeriod=10,nDo=5,out=prefix+'-{step}.wooc',fullEvery=3,wait=True,label='ckpt')]
+		S.run(50,True)
+		S.lab.ckpt.flush()
+		self.assert_(S.lab.ckpt.nSaved==5)
+		# full at 0 and 30, deltas at 10, 20 and 40
+		self.assert_(S.lab.ckpt.lastFull==prefix+'-30.wooc')
+		S2=Object.load(prefix+'-40.wooc')
+		self.assert_(S2.step==40 and len(S2.dem.par)==len(S.dem.par))